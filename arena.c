@@ -0,0 +1,163 @@
+#include "arena.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "counters.h"
+#include "debug.h"
+
+// Align blocks to 16 bytes as it is required by PSP device
+#define ARENA_ALIGNMENT 16
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+struct ArenaBlock {
+  // NULL for plain heap blocks of vectors created without selected arena
+  Arena *arena;
+  size_t size;
+  // Only used by blocks allocated from heap after arena overflow
+  ArenaBlock *next;
+};
+
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ALIGN(sizeof(ArenaBlock))
+
+static Arena *vector_arena = NULL;
+
+static ArenaBlock *get_block(void *ptr) { return (ArenaBlock *)((uint8_t *)ptr - ARENA_BLOCK_HEADER_SIZE); }
+
+static void *get_block_data(ArenaBlock *block) { return (uint8_t *)block + ARENA_BLOCK_HEADER_SIZE; }
+
+static void update_high_water(Arena *arena) {
+  size_t used = arena->offset + arena->overflow_size;
+  if (used > arena->high_water) arena->high_water = used;
+}
+
+void arena_init(Arena *arena, const char *name, size_t capacity) {
+  arena->name = name;
+  arena->data = memalign(ARENA_ALIGNMENT, capacity);
+  arena->capacity = arena->data != NULL ? capacity : 0;
+  arena->offset = 0;
+  arena->high_water = 0;
+  arena->overflow_size = 0;
+  arena->overflow = NULL;
+
+  if (arena->data == NULL) log_message(LOG_ERROR, "Failed to allocate %s arena, its blocks will use heap.", name);
+}
+
+void arena_reset(Arena *arena) {
+  ArenaBlock *block = arena->overflow;
+  while (block != NULL) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  arena->overflow = NULL;
+  arena->overflow_size = 0;
+  arena->offset = 0;
+}
+
+void arena_destroy(Arena *arena) {
+  arena_reset(arena);
+  free(arena->data);
+
+  if (vector_arena == arena) vector_arena = NULL;
+  memset(arena, 0, sizeof(Arena));
+}
+
+void arena_log_usage(Arena *arena) {
+  log_message(LOG_INFO, "%s arena high-water mark: %zu/%zu bytes.", arena->name, arena->high_water, arena->capacity);
+}
+
+void *arena_allocate(Arena *arena, size_t size) {
+  size = ARENA_ALIGN(size);
+  size_t total_size = ARENA_BLOCK_HEADER_SIZE + size;
+
+  ArenaBlock *block;
+  if (arena->offset + total_size <= arena->capacity) {
+    block = (ArenaBlock *)&arena->data[arena->offset];
+    block->next = NULL;
+    arena->offset += total_size;
+  } else {
+    block = malloc(total_size);
+    if (block == NULL) {
+      log_message(LOG_ERROR, "%s arena overflow: Failed to allocate memory.", arena->name);
+      return NULL;
+    }
+
+    if (arena->overflow == NULL)
+      log_message(LOG_WARNING, "%s arena overflow: Falling back to heap allocations.", arena->name);
+
+    block->next = arena->overflow;
+    arena->overflow = block;
+    arena->overflow_size += total_size;
+  }
+
+  block->arena = arena;
+  block->size = size;
+  update_high_water(arena);
+
+  return get_block_data(block);
+}
+
+void *arena_reallocate(void *ptr, size_t size) {
+  ArenaBlock *block = get_block(ptr);
+  Arena *arena = block->arena;
+
+  // Shrinking keeps the whole block, so growing back later stays in place
+  if (size <= block->size) return ptr;
+
+  // Last block in buffer can simply be extended
+  size = ARENA_ALIGN(size);
+  if ((uint8_t *)ptr + block->size == arena->data + arena->offset &&
+      arena->offset + size - block->size <= arena->capacity) {
+    arena->offset += size - block->size;
+    block->size = size;
+    update_high_water(arena);
+    return ptr;
+  }
+
+  // Old block stays reserved until reset, so grow at least twice to keep total waste proportional to final size
+  void *new_ptr = arena_allocate(arena, size > 2 * block->size ? size : 2 * block->size);
+  if (new_ptr == NULL) return NULL;
+
+  memcpy(new_ptr, ptr, block->size);
+  return new_ptr;
+}
+
+Arena *set_vector_arena(Arena *arena) {
+  Arena *previous = vector_arena;
+  vector_arena = arena;
+  return previous;
+}
+
+void *vector_allocate(size_t size) {
+  if (vector_arena != NULL) return arena_allocate(vector_arena, size);
+
+  ArenaBlock *block = malloc(ARENA_BLOCK_HEADER_SIZE + size);
+  if (block == NULL) return NULL;
+
+  block->arena = NULL;
+  block->size = size;
+  return get_block_data(block);
+}
+
+void *vector_reallocate(void *ptr, size_t size) {
+  COUNTER_INC(COUNTER_VECTOR_REALLOCATIONS);
+
+  ArenaBlock *block = get_block(ptr);
+  if (block->arena != NULL) return arena_reallocate(ptr, size);
+
+  block = realloc(block, ARENA_BLOCK_HEADER_SIZE + size);
+  if (block == NULL) return NULL;
+
+  block->size = size;
+  return get_block_data(block);
+}
+
+void vector_free(void *ptr) {
+  ArenaBlock *block = get_block(ptr);
+
+  // Arena blocks are released all at once when their arena is reset
+  if (block->arena == NULL) free(block);
+}
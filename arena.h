@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Bump allocator with single backing buffer. Blocks are never freed individually,
+// whole arena is released at once with reset. When buffer runs out, blocks are taken
+// from heap instead and still released together with the arena.
+typedef struct {
+  const char *name;
+  uint8_t *data;
+  size_t capacity;
+  size_t offset;
+  size_t high_water;
+  size_t overflow_size;
+  ArenaBlock *overflow;
+} Arena;
+
+void arena_init(Arena *arena, const char *name, size_t capacity);
+void arena_destroy(Arena *arena);
+void arena_reset(Arena *arena);
+void arena_log_usage(Arena *arena);
+
+void *arena_allocate(Arena *arena, size_t size);
+void *arena_reallocate(void *ptr, size_t size);
+
+// Selects arena used by vectors created from now on, returns previously selected one.
+// Vectors that already exist keep growing inside arena they were created in.
+Arena *set_vector_arena(Arena *arena);
+
+// Allocation hooks used by cvector, see vector.h
+void *vector_allocate(size_t size);
+void *vector_reallocate(void *ptr, size_t size);
+void vector_free(void *ptr);
+
+#endif
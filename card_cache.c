@@ -0,0 +1,66 @@
+#include "card_cache.h"
+
+#include <stdlib.h>
+
+#include "debug.h"
+#include "gfx.h"
+
+static Texture *cache_texture = NULL;
+static CardCacheSlot slots[CARD_CACHE_SLOT_COUNT];
+static Rect slot_rect;
+
+static uint32_t access_count = 0;
+static uint32_t miss_count = 0;
+
+void card_cache_init() {
+  cache_texture = init_texture(CARD_CACHE_WIDTH, CARD_CACHE_HEIGHT);
+  if (cache_texture == NULL || cache_texture->data == NULL)
+    log_message(LOG_ERROR, "Failed to allocate card cache, card layers will be drawn separately.");
+}
+
+void card_cache_destroy() {
+  log_message(LOG_INFO, "Card cache: %u lookups, %u misses.", access_count, miss_count);
+
+  free(cache_texture);
+  cache_texture = NULL;
+}
+
+Rect *get_cached_card(uint32_t key, SpriteLayer *layers, uint8_t count) {
+  if (cache_texture == NULL || cache_texture->data == NULL) return NULL;
+  // Slot would keep missing layers, atlases which are still being decoded are skipped by draw_texture instead
+  for (uint8_t i = 0; i < count; i++)
+    if (layers[i].atlas->data == NULL) return NULL;
+
+  access_count++;
+
+  // Least recently used slot is replaced on miss, empty slots have never been used
+  uint8_t index = 0;
+  for (uint8_t i = 0; i < CARD_CACHE_SLOT_COUNT; i++) {
+    if (slots[i].key == key) {
+      index = i;
+      break;
+    }
+
+    if (slots[i].last_used < slots[index].last_used) index = i;
+  }
+
+  slot_rect = (Rect){.x = (index % CARD_CACHE_COLUMNS) * CARD_WIDTH,
+                     .y = (index / CARD_CACHE_COLUMNS) * CARD_HEIGHT,
+                     .w = CARD_WIDTH,
+                     .h = CARD_HEIGHT};
+
+  // Composited once into VRAM, so each next draw of the same card is a single sprite
+  if (slots[index].key != key) {
+    miss_count++;
+    slots[index].key = key;
+
+    begin_texture_render(cache_texture, &slot_rect);
+    render_sprite_layers(layers, count, &slot_rect, 0);
+    end_texture_render();
+  }
+
+  slots[index].last_used = access_count;
+  return &slot_rect;
+}
+
+Texture *get_card_cache_texture() { return cache_texture; }
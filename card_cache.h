@@ -0,0 +1,40 @@
+#ifndef CARD_CACHE_H
+#define CARD_CACHE_H
+
+#include <stdint.h>
+
+#include "system.h"
+
+// Cache texture lives in VRAM next to frame buffers, 480x256 of it is used by 10x4 card slots
+#define CARD_CACHE_WIDTH (512)
+#define CARD_CACHE_HEIGHT (256)
+#define CARD_CACHE_COLUMNS (10)
+#define CARD_CACHE_ROWS (4)
+#define CARD_CACHE_SLOT_COUNT (CARD_CACHE_COLUMNS * CARD_CACHE_ROWS)
+
+#define CARD_CACHE_MAX_LAYERS (4)
+
+// Highest bits of key tell which kind of item it belongs to, so keys of cards and jokers never collide
+#define CARD_CACHE_KEY_CARD (1u << 28)
+#define CARD_CACHE_KEY_JOKER (2u << 28)
+
+typedef struct {
+  Texture *atlas;
+  Vector2 sprite;
+} SpriteLayer;
+
+typedef struct {
+  // 0 marks empty slot
+  uint32_t key;
+  uint32_t last_used;
+} CardCacheSlot;
+
+void card_cache_init();
+void card_cache_destroy();
+
+// Returns area of cache texture with layers composited on top of each other, rendering them first on miss.
+// NULL if cache is not available, then layers have to be drawn separately.
+Rect *get_cached_card(uint32_t key, SpriteLayer *layers, uint8_t count);
+Texture *get_card_cache_texture();
+
+#endif
@@ -0,0 +1,236 @@
+#include "compositor.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gfx.h"
+#include "renderer.h"
+#include "state.h"
+
+#define FNV_OFFSET_BASIS (2166136261u)
+#define FNV_PRIME (16777619u)
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t size) {
+  const uint8_t *bytes = data;
+  for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * FNV_PRIME;
+  return hash;
+}
+
+// Only fields that are drawn are hashed, bytes of the rest of union and of padding are left undefined
+static uint32_t hash_custom_element(uint32_t hash, CustomElementData *element) {
+  uint32_t key = 0;
+  switch (element->type) {
+    case CUSTOM_ELEMENT_CARD:
+      key = element->card.suit | element->card.rank << 4 | element->card.enhancement << 8 |
+            element->card.edition << 16 | element->card.seal << 20 | element->card.status << 24;
+      break;
+    case CUSTOM_ELEMENT_JOKER:
+      key = element->joker.id | element->joker.edition << 16 | element->joker.status << 24;
+      break;
+    case CUSTOM_ELEMENT_CONSUMABLE:
+      key = element->consumable.type;
+      break;
+    case CUSTOM_ELEMENT_VOUCHER:
+      key = element->voucher;
+      break;
+    case CUSTOM_ELEMENT_BOOSTER_PACK:
+      key = element->booster_pack.type | element->booster_pack.size << 8;
+      break;
+    case CUSTOM_ELEMENT_DECK:
+      key = element->deck;
+      break;
+  }
+
+  hash = hash_bytes(hash, &element->type, sizeof(element->type));
+  return hash_bytes(hash, &key, sizeof(key));
+}
+
+// Everything that affects pixels drawn by the command, except for the animation layer
+static uint32_t hash_render_command(Clay_RenderCommand *render_command) {
+  uint32_t hash = FNV_OFFSET_BASIS;
+  hash = hash_bytes(hash, &render_command->commandType, sizeof(render_command->commandType));
+  hash = hash_bytes(hash, &render_command->boundingBox, sizeof(render_command->boundingBox));
+
+  Clay_RenderData *data = &render_command->renderData;
+  switch (render_command->commandType) {
+    case CLAY_RENDER_COMMAND_TYPE_RECTANGLE:
+      hash = hash_bytes(hash, &data->rectangle.backgroundColor, sizeof(data->rectangle.backgroundColor));
+      break;
+
+    case CLAY_RENDER_COMMAND_TYPE_TEXT:
+      // Strings live in frame arena, so their content has to be compared instead of pointers
+      hash = hash_bytes(hash, data->text.stringContents.chars, data->text.stringContents.length);
+      hash = hash_bytes(hash, &data->text.textColor, sizeof(data->text.textColor));
+      break;
+
+    case CLAY_RENDER_COMMAND_TYPE_BORDER:
+      hash = hash_bytes(hash, &data->border.color, sizeof(data->border.color));
+      hash = hash_bytes(hash, &data->border.width, sizeof(data->border.width));
+      break;
+
+    case CLAY_RENDER_COMMAND_TYPE_IMAGE:
+      hash = hash_bytes(hash, &data->image.imageData, sizeof(data->image.imageData));
+      break;
+
+    case CLAY_RENDER_COMMAND_TYPE_CUSTOM:
+      if (data->custom.customData != NULL) hash = hash_custom_element(hash, data->custom.customData);
+      break;
+
+    default:
+      break;
+  }
+
+  return hash;
+}
+
+static int compare_signatures(const void *a, const void *b) {
+  uint32_t hash_a = ((const CommandSignature *)a)->hash;
+  uint32_t hash_b = ((const CommandSignature *)b)->hash;
+  return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+static void merge_dirty_rect(DirtyRect *rect, DirtyRect *other) {
+  if (other->x1 <= other->x0 || other->y1 <= other->y0) return;
+
+  if (rect->x1 <= rect->x0) {
+    *rect = *other;
+    return;
+  }
+
+  if (other->x0 < rect->x0) rect->x0 = other->x0;
+  if (other->y0 < rect->y0) rect->y0 = other->y0;
+  if (other->x1 > rect->x1) rect->x1 = other->x1;
+  if (other->y1 > rect->y1) rect->y1 = other->y1;
+}
+
+static void add_dirty_rect(DirtyRect *rect, float x, float y, float w, float h) {
+  DirtyRect other = {
+      .x0 = (int16_t)fmaxf(floorf(x) - COMPOSITOR_DIRTY_MARGIN, 0),
+      .y0 = (int16_t)fmaxf(floorf(y) - COMPOSITOR_DIRTY_MARGIN, 0),
+      .x1 = (int16_t)fminf(ceilf(x + w) + COMPOSITOR_DIRTY_MARGIN, SCREEN_WIDTH),
+      .y1 = (int16_t)fminf(ceilf(y + h) + COMPOSITOR_DIRTY_MARGIN, SCREEN_HEIGHT),
+  };
+  merge_dirty_rect(rect, &other);
+}
+
+static void add_dirty_box(Clay_BoundingBox *box) {
+  for (uint8_t i = 0; i < 2; i++)
+    add_dirty_rect(&state.compositor.dirty[i], box->x, box->y, box->width, box->height);
+}
+
+void compositor_init(CompositeMode mode) {
+  state.compositor.animation_interval = ANIMATION_FRAME_INTERVAL;
+  state.compositor.frame = 0;
+  state.compositor.animation_step = 0;
+  state.compositor.draw_buffer = 0;
+  state.compositor.stale[0] = state.compositor.stale[1] = (DirtyRect){0};
+  state.compositor.signature_count = 0;
+  compositor_set_mode(mode);
+}
+
+void compositor_set_mode(CompositeMode mode) {
+  state.compositor.mode = mode;
+  state.compositor.signature_count = 0;
+  state.compositor.animated = (DirtyRect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+  compositor_mark_all_dirty();
+}
+
+void compositor_set_animation_interval(uint8_t interval) { state.compositor.animation_interval = interval; }
+
+void compositor_track_layout(Clay_RenderCommandArray *render_commands) {
+  Compositor *compositor = &state.compositor;
+  if (compositor->mode == COMPOSITE_FULL) {
+    compositor_mark_all_dirty();
+    return;
+  }
+
+  if (render_commands->length > COMPOSITOR_MAX_COMMANDS) {
+    compositor->signature_count = 0;
+    compositor->animated = (DirtyRect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    compositor_mark_all_dirty();
+    return;
+  }
+
+  static CommandSignature signatures[COMPOSITOR_MAX_COMMANDS];
+  uint16_t count = render_commands->length;
+  // Custom elements are the only sprites that move with animation layer
+  compositor->animated = (DirtyRect){0};
+  for (uint16_t i = 0; i < count; i++) {
+    Clay_RenderCommand *render_command = Clay_RenderCommandArray_Get(render_commands, i);
+    Clay_BoundingBox *box = &render_command->boundingBox;
+    signatures[i] = (CommandSignature){.hash = hash_render_command(render_command), .bounding_box = *box};
+
+    if (render_command->commandType == CLAY_RENDER_COMMAND_TYPE_CUSTOM)
+      add_dirty_rect(&compositor->animated, box->x, box->y, box->width, box->height);
+  }
+  qsort(signatures, count, sizeof(CommandSignature), compare_signatures);
+
+  // Commands present only in one of layouts have appeared, disappeared, moved or changed,
+  // so both their old and new areas have to be redrawn
+  uint16_t i = 0, j = 0;
+  while (i < compositor->signature_count || j < count) {
+    if (j == count || (i < compositor->signature_count && compositor->signatures[i].hash < signatures[j].hash)) {
+      add_dirty_box(&compositor->signatures[i++].bounding_box);
+    } else if (i == compositor->signature_count || signatures[j].hash < compositor->signatures[i].hash) {
+      add_dirty_box(&signatures[j++].bounding_box);
+    } else {
+      i++;
+      j++;
+    }
+  }
+
+  memcpy(compositor->signatures, signatures, count * sizeof(CommandSignature));
+  compositor->signature_count = count;
+}
+
+void compositor_mark_dirty(Rect *rect) {
+  for (uint8_t i = 0; i < 2; i++) add_dirty_rect(&state.compositor.dirty[i], rect->x, rect->y, rect->w, rect->h);
+}
+
+void compositor_mark_all_dirty() { compositor_mark_dirty(&(Rect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT}); }
+
+uint8_t compositor_begin_frame(Rect *region) {
+  Compositor *compositor = &state.compositor;
+
+  // Animation layer is advanced in steps instead of every frame. Other buffer is not redrawn right away,
+  // it would be overwritten by the next step anyway.
+  uint8_t draw_buffer = compositor->draw_buffer;
+  if (compositor->animation_interval > 0 && compositor->frame++ % compositor->animation_interval == 0) {
+    state.animation_time = state.time;
+
+    DirtyRect step = compositor->animated;
+    if (compositor->animation_step++ % BACKGROUND_STEP_INTERVAL == 0) {
+      state.background_time = state.time;
+      step = (DirtyRect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    }
+
+    merge_dirty_rect(&compositor->dirty[draw_buffer], &step);
+    merge_dirty_rect(&compositor->stale[draw_buffer ^ 1], &step);
+  }
+
+  DirtyRect *dirty = &compositor->dirty[draw_buffer];
+  if (dirty->x1 <= dirty->x0) return 0;
+
+  if (compositor->mode == COMPOSITE_FULL)
+    *dirty = (DirtyRect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+  else
+    merge_dirty_rect(dirty, &compositor->stale[draw_buffer]);
+
+  *region = (Rect){dirty->x0, dirty->y0, dirty->x1 - dirty->x0, dirty->y1 - dirty->y0};
+  return 1;
+}
+
+void compositor_end_frame() {
+  Compositor *compositor = &state.compositor;
+  compositor->dirty[compositor->draw_buffer] = (DirtyRect){0};
+  compositor->stale[compositor->draw_buffer] = (DirtyRect){0};
+  compositor->draw_buffer ^= 1;
+}
+
+uint8_t is_region_visible(Rect *region, Clay_BoundingBox *bounding_box) {
+  return bounding_box->x - COMPOSITOR_DIRTY_MARGIN < region->x + region->w &&
+         bounding_box->x + bounding_box->width + COMPOSITOR_DIRTY_MARGIN > region->x &&
+         bounding_box->y - COMPOSITOR_DIRTY_MARGIN < region->y + region->h &&
+         bounding_box->y + bounding_box->height + COMPOSITOR_DIRTY_MARGIN > region->y;
+}
@@ -0,0 +1,73 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <clay.h>
+#include <stdint.h>
+
+#include "system.h"
+
+// More render commands than this always redraw the whole screen
+#define COMPOSITOR_MAX_COMMANDS (512)
+
+// Sprites are rotated around their bounding box center, so they can reach slightly outside of it
+#define COMPOSITOR_DIRTY_MARGIN (4)
+
+// Animation layer is advanced once per this many frames, frame scheduler adjusts it at runtime
+#define ANIMATION_FRAME_INTERVAL (2)
+// Background scrolls by about a pixel per this many animation steps, so it is moved only on them.
+// Other steps redraw only the area of animated sprites instead of the whole screen.
+#define BACKGROUND_STEP_INTERVAL (8)
+
+typedef enum {
+  // Whole screen is redrawn whenever anything changes
+  COMPOSITE_FULL,
+  // Only changed screen regions are redrawn, frames without changes are skipped
+  COMPOSITE_DIRTY_RECTS,
+} CompositeMode;
+
+// Union of changed regions in screen pixels, empty when x1 <= x0
+typedef struct {
+  int16_t x0, y0, x1, y1;
+} DirtyRect;
+
+typedef struct {
+  uint32_t hash;
+  Clay_BoundingBox bounding_box;
+} CommandSignature;
+
+typedef struct {
+  CompositeMode mode;
+  // 0 freezes animations, so unchanged frames cost only the wait for vblank
+  uint8_t animation_interval;
+  uint32_t frame;
+  uint32_t animation_step;
+  // Union of animated sprites of the current layout
+  DirtyRect animated;
+
+  // Draw buffer alternates after every swap and still holds the frame drawn two swaps ago,
+  // so each buffer keeps its own region which has changed since it was drawn last time
+  uint8_t draw_buffer;
+  DirtyRect dirty[2];
+  // Region where buffer holds older step of animation layer, it is redrawn next time anything changes
+  DirtyRect stale[2];
+
+  // Signatures of the previous layout sorted by hash
+  CommandSignature signatures[COMPOSITOR_MAX_COMMANDS];
+  uint16_t signature_count;
+} Compositor;
+
+void compositor_init(CompositeMode mode);
+void compositor_set_mode(CompositeMode mode);
+void compositor_set_animation_interval(uint8_t interval);
+
+void compositor_track_layout(Clay_RenderCommandArray *render_commands);
+void compositor_mark_dirty(Rect *rect);
+void compositor_mark_all_dirty();
+
+// Returns 0 when draw buffer is already up to date, otherwise sets region that has to be redrawn
+uint8_t compositor_begin_frame(Rect *region);
+void compositor_end_frame();
+
+uint8_t is_region_visible(Rect *region, Clay_BoundingBox *bounding_box);
+
+#endif
@@ -5,14 +5,14 @@
 static void activate_joker_joker(Joker *self) { state.game.selected_hand.score_pair.mult += 4; }
 
 static void activate_basic_suit_plus_mult(Joker *self, Card *card) {
-  if (card->suit == self->suit) state.game.selected_hand.score_pair.mult += 3;
+  if (card->suit == self->scaling.suit) state.game.selected_hand.score_pair.mult += 3;
 }
 
 static void activate_basic_hand_plus_mult(Joker *self) {
-  if (!does_poker_hand_contain(state.game.selected_hand.hand_union, self->hand)) return;
+  if (!does_poker_hand_contain(state.game.selected_hand.hand_union, self->scaling.hand)) return;
 
   uint8_t mult = 0;
-  switch (self->hand) {
+  switch (self->scaling.hand) {
     case HAND_PAIR:
       mult = 8;
       break;
@@ -30,10 +30,10 @@ static void activate_basic_hand_plus_mult(Joker *self) {
 }
 
 static void activate_basic_hand_plus_chips(Joker *self) {
-  if (!does_poker_hand_contain(state.game.selected_hand.hand_union, self->hand)) return;
+  if (!does_poker_hand_contain(state.game.selected_hand.hand_union, self->scaling.hand)) return;
 
   uint8_t chips = 0;
-  switch (self->hand) {
+  switch (self->scaling.hand) {
     case HAND_PAIR:
       chips = 50;
       break;
@@ -50,141 +50,116 @@ static void activate_basic_hand_plus_chips(Joker *self) {
   state.game.selected_hand.score_pair.chips += chips;
 }
 
-const Joker JOKERS[] = {
-    {
-        .id = JOKER_JOKER,
-        .name = "Joker",
-        .description = "+4 mult when scored",
-        .base_price = 2,
-        .rarity = RARITY_COMMON,
-        .activate_independent = activate_joker_joker,
-    },
-    {
-        .id = JOKER_GREEDY,
-        .name = "Greedy Joker",
-        .description = "Played cards with Diamond suit give +3 Mult when scored",
-        .base_price = 5,
-        .rarity = RARITY_COMMON,
-        .suit = SUIT_DIAMONDS,
-        .activate_on_scored = activate_basic_suit_plus_mult,
-    },
-    {
-        .id = JOKER_LUSTY,
-        .name = "Lusty Joker",
-        .description = "Played cards with Heart suit give +3 Mult when scored",
-        .base_price = 5,
-        .rarity = RARITY_COMMON,
-        .suit = SUIT_HEARTS,
-        .activate_on_scored = activate_basic_suit_plus_mult,
-    },
-    {
-        .id = JOKER_WRATHFUL,
-        .name = "Wrathful Joker",
-        .description = "Played cards with Spade suit give +3 Mult when scored",
-        .base_price = 5,
-        .rarity = RARITY_COMMON,
-        .suit = SUIT_SPADES,
-        .activate_on_scored = activate_basic_suit_plus_mult,
-    },
-    {
-        .id = JOKER_GLUTTONOUS,
-        .name = "Gluttonous Joker",
-        .description = "Played cards with Club suit give +3 Mult when scored",
-        .base_price = 5,
-        .rarity = RARITY_COMMON,
-        .suit = SUIT_CLUBS,
-        .activate_on_scored = activate_basic_suit_plus_mult,
-    },
-    {
-        .id = JOKER_JOLLY,
-        .name = "Jolly Joker",
-        .description = "+8 Mult if played hand contains a Pair",
-        .base_price = 3,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_PAIR,
-        .activate_independent = activate_basic_hand_plus_mult,
-    },
-    {
-        .id = JOKER_ZANY,
-        .name = "Zany Joker",
-        .description = "+12 Mult if played hand contains a Three of a Kind",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_THREE_OF_KIND,
-        .activate_independent = activate_basic_hand_plus_mult,
-    },
-    {
-        .id = JOKER_MAD,
-        .name = "Mad Joker",
-        .description = "+10 Mult if played hand contains a Two Pair",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_TWO_PAIR,
-        .activate_independent = activate_basic_hand_plus_mult,
-    },
-    {
-        .id = JOKER_CRAZY,
-        .name = "Crazy Joker",
-        .description = "+12 Mult if played hand contains a Straight",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_STRAIGHT,
-        .activate_independent = activate_basic_hand_plus_mult,
-    },
-    {
-        .id = JOKER_DROLL,
-        .name = "Droll Joker",
-        .description = "+10 Mult if played hand contains a Flush",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_FLUSH,
-        .activate_independent = activate_basic_hand_plus_mult,
-    },
-    {
-        .id = JOKER_SLY,
-        .name = "Sly Joker",
-        .description = "+50 Chips if played hand contains a Pair",
-        .base_price = 3,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_PAIR,
-        .activate_independent = activate_basic_hand_plus_chips,
-    },
-    {
-        .id = JOKER_WILY,
-        .name = "Wily Joker",
-        .description = "+100 Chips if played hand contains a Three of a Kind",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_THREE_OF_KIND,
-        .activate_independent = activate_basic_hand_plus_chips,
-    },
-    {
-        .id = JOKER_CLEVER,
-        .name = "Clever Joker",
-        .description = "+80 Chips if played hand contains a Two Pair",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_TWO_PAIR,
-        .activate_independent = activate_basic_hand_plus_chips,
-    },
-    {
-        .id = JOKER_DEVIOUS,
-        .name = "Devious Joker",
-        .description = "+100 Chips if played hand contains a Straight",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_STRAIGHT,
-        .activate_independent = activate_basic_hand_plus_chips,
-    },
-    {
-        .id = JOKER_CRAFTY,
-        .name = "Craft Joker",
-        .description = "+80 Chips if played hand contains a Flush",
-        .base_price = 4,
-        .rarity = RARITY_COMMON,
-        .hand = HAND_FLUSH,
-        .activate_independent = activate_basic_hand_plus_chips,
-    },
+const JokerDef JOKERS[JOKER_ID_COUNT] = {
+    [JOKER_JOKER] =
+        {
+            .description = "+4 mult when scored",
+            .base_price = 2,
+            .activate_independent = activate_joker_joker,
+        },
+    [JOKER_GREEDY] =
+        {
+            .description = "Played cards with Diamond suit give +3 Mult when scored",
+            .base_price = 5,
+            .scaling.suit = SUIT_DIAMONDS,
+            .activate_on_scored = activate_basic_suit_plus_mult,
+        },
+    [JOKER_LUSTY] =
+        {
+            .description = "Played cards with Heart suit give +3 Mult when scored",
+            .base_price = 5,
+            .scaling.suit = SUIT_HEARTS,
+            .activate_on_scored = activate_basic_suit_plus_mult,
+        },
+    [JOKER_WRATHFUL] =
+        {
+            .description = "Played cards with Spade suit give +3 Mult when scored",
+            .base_price = 5,
+            .scaling.suit = SUIT_SPADES,
+            .activate_on_scored = activate_basic_suit_plus_mult,
+        },
+    [JOKER_GLUTTONOUS] =
+        {
+            .description = "Played cards with Club suit give +3 Mult when scored",
+            .base_price = 5,
+            .scaling.suit = SUIT_CLUBS,
+            .activate_on_scored = activate_basic_suit_plus_mult,
+        },
+    [JOKER_JOLLY] =
+        {
+            .description = "+8 Mult if played hand contains a Pair",
+            .base_price = 3,
+            .scaling.hand = HAND_PAIR,
+            .activate_independent = activate_basic_hand_plus_mult,
+        },
+    [JOKER_ZANY] =
+        {
+            .description = "+12 Mult if played hand contains a Three of a Kind",
+            .base_price = 4,
+            .scaling.hand = HAND_THREE_OF_KIND,
+            .activate_independent = activate_basic_hand_plus_mult,
+        },
+    [JOKER_MAD] =
+        {
+            .description = "+10 Mult if played hand contains a Two Pair",
+            .base_price = 4,
+            .scaling.hand = HAND_TWO_PAIR,
+            .activate_independent = activate_basic_hand_plus_mult,
+        },
+    [JOKER_CRAZY] =
+        {
+            .description = "+12 Mult if played hand contains a Straight",
+            .base_price = 4,
+            .scaling.hand = HAND_STRAIGHT,
+            .activate_independent = activate_basic_hand_plus_mult,
+        },
+    [JOKER_DROLL] =
+        {
+            .description = "+10 Mult if played hand contains a Flush",
+            .base_price = 4,
+            .scaling.hand = HAND_FLUSH,
+            .activate_independent = activate_basic_hand_plus_mult,
+        },
+    [JOKER_SLY] =
+        {
+            .description = "+50 Chips if played hand contains a Pair",
+            .base_price = 3,
+            .scaling.hand = HAND_PAIR,
+            .activate_independent = activate_basic_hand_plus_chips,
+        },
+    [JOKER_WILY] =
+        {
+            .description = "+100 Chips if played hand contains a Three of a Kind",
+            .base_price = 4,
+            .scaling.hand = HAND_THREE_OF_KIND,
+            .activate_independent = activate_basic_hand_plus_chips,
+        },
+    [JOKER_CLEVER] =
+        {
+            .description = "+80 Chips if played hand contains a Two Pair",
+            .base_price = 4,
+            .scaling.hand = HAND_TWO_PAIR,
+            .activate_independent = activate_basic_hand_plus_chips,
+        },
+    [JOKER_DEVIOUS] =
+        {
+            .description = "+100 Chips if played hand contains a Straight",
+            .base_price = 4,
+            .scaling.hand = HAND_STRAIGHT,
+            .activate_independent = activate_basic_hand_plus_chips,
+        },
+    [JOKER_CRAFTY] =
+        {
+            .description = "+80 Chips if played hand contains a Flush",
+            .base_price = 4,
+            .scaling.hand = HAND_FLUSH,
+            .activate_independent = activate_basic_hand_plus_chips,
+        },
 };
 
-const uint8_t JOKER_COUNT = sizeof(JOKERS) / sizeof(Joker);
+// Ids start from 1
+const uint8_t JOKER_COUNT = JOKER_ID_COUNT - 1;
+
+Joker create_joker(JokerId id, Edition edition) {
+  return (Joker){.id = id, .edition = edition, .status = CARD_STATUS_NORMAL, .scaling = JOKERS[id].scaling};
+}
@@ -4,14 +4,26 @@
 #include <clay.h>
 #include <stdint.h>
 
+#include "../counters.h"
+
 struct Card;
 
-#define TRIGGER_JOKER(joker, TYPE, ...)                                         \
-  do {                                                                          \
-    if (!(joker->status & CARD_STATUS_DEBUFFED)) {                              \
-      if (joker->scale_##TYPE) joker->scale_##TYPE(joker, ##__VA_ARGS__);       \
-      if (joker->activate_##TYPE) joker->activate_##TYPE(joker, ##__VA_ARGS__); \
-    }                                                                           \
+#define JOKER_HOOK_COUNTER_on_played COUNTER_JOKER_ON_PLAYED
+#define JOKER_HOOK_COUNTER_on_scored COUNTER_JOKER_ON_SCORED
+#define JOKER_HOOK_COUNTER_on_held COUNTER_JOKER_ON_HELD
+#define JOKER_HOOK_COUNTER_independent COUNTER_JOKER_INDEPENDENT
+#define JOKER_HOOK_COUNTER_on_other_jokers COUNTER_JOKER_ON_OTHER_JOKERS
+#define JOKER_HOOK_COUNTER_on_discard COUNTER_JOKER_ON_DISCARD
+#define JOKER_HOOK_COUNTER_on_blind_select COUNTER_JOKER_ON_BLIND_SELECT
+
+#define TRIGGER_JOKER(joker, TYPE, ...)                                                                  \
+  do {                                                                                                   \
+    if (!(joker->status & CARD_STATUS_DEBUFFED)) {                                                       \
+      const JokerDef *joker_def = &JOKERS[joker->id];                                                    \
+      if (joker_def->scale_##TYPE || joker_def->activate_##TYPE) COUNTER_INC(JOKER_HOOK_COUNTER_##TYPE); \
+      if (joker_def->scale_##TYPE) joker_def->scale_##TYPE(joker, ##__VA_ARGS__);                        \
+      if (joker_def->activate_##TYPE) joker_def->activate_##TYPE(joker, ##__VA_ARGS__);                  \
+    }                                                                                                    \
   } while (0)
 
 typedef enum {
@@ -30,6 +42,8 @@ typedef enum {
   JOKER_CLEVER,
   JOKER_DEVIOUS,
   JOKER_CRAFTY,
+
+  JOKER_ID_COUNT
 } JokerId;
 
 typedef enum { EDITION_BASE, EDITION_FOIL, EDITION_HOLOGRAPHIC, EDITION_POLYCHROME, EDITION_NEGATIVE } Edition;
@@ -38,48 +52,62 @@ typedef enum { RARITY_COMMON, RARITY_UNCOMMON, RARITY_RARE, RARITY_LEGENDARY } R
 
 typedef enum { CARD_STATUS_NORMAL = 0, CARD_STATUS_FACE_DOWN = 1 << 0, CARD_STATUS_DEBUFFED = 1 << 1 } CardStatus;
 
+typedef union {
+  double mult;
+  uint16_t chips;
+  uint8_t counter;
+  // Suit enum
+  uint8_t suit;
+  // PokerHand enum
+  uint16_t hand;
+} JokerScaling;
+
+// Owned or offered joker, everything that is the same for all jokers with its id lives in JokerDef
 typedef struct Joker {
   JokerId id;
-  const char *name;
-  const char *description;
-  void (*get_scaling_description)(struct Joker *self, Clay_String *dest);
-  uint8_t base_price;
-
-  Rarity rarity;
   Edition edition;
   CardStatus status;
+  JokerScaling scaling;
+} Joker;
+
+typedef struct {
+  const char *description;
+  void (*get_scaling_description)(Joker *self, Clay_String *dest);
+  uint8_t base_price;
   bool is_non_copyable;
+  // Copied into every created joker
+  JokerScaling scaling;
 
-  void (*activate_on_played)(struct Joker *self);
-  void (*activate_on_scored)(struct Joker *self, struct Card *card);
-  void (*activate_on_held)(struct Joker *self, struct Card *card);
-  void (*activate_independent)(struct Joker *self);
-  void (*activate_on_other_jokers)(struct Joker *self, struct Joker *other);
-  void (*activate_on_discard)(struct Joker *self, struct Card *card);
-  void (*activate_on_blind_select)(struct Joker *self);
-  void (*activate_passive)(struct Joker *self);
-
-  void (*scale_on_played)(struct Joker *self);
-  void (*scale_on_scored)(struct Joker *self, struct Card *card);
-  void (*scale_on_held)(struct Joker *self, struct Card *card);
-  void (*scale_independent)(struct Joker *self);
-  void (*scale_on_other_jokers)(struct Joker *self, struct Joker *other);
-  void (*scale_on_discard)(struct Joker *self, struct Card *card);
-  void (*scale_on_blind_select)(struct Joker *self);
-  void (*scale_passive)(struct Joker *self);
-
-  union {
-    double mult;
-    uint16_t chips;
-    uint8_t counter;
-    // Suit enum
-    uint8_t suit;
-    // PokerHand enum
-    uint16_t hand;
-  };
-} Joker;
+  void (*activate_on_played)(Joker *self);
+  void (*activate_on_scored)(Joker *self, struct Card *card);
+  void (*activate_on_held)(Joker *self, struct Card *card);
+  void (*activate_independent)(Joker *self);
+  void (*activate_on_other_jokers)(Joker *self, Joker *other);
+  void (*activate_on_discard)(Joker *self, struct Card *card);
+  void (*activate_on_blind_select)(Joker *self);
+  void (*activate_passive)(Joker *self);
+
+  void (*scale_on_played)(Joker *self);
+  void (*scale_on_scored)(Joker *self, struct Card *card);
+  void (*scale_on_held)(Joker *self, struct Card *card);
+  void (*scale_independent)(Joker *self);
+  void (*scale_on_other_jokers)(Joker *self, Joker *other);
+  void (*scale_on_discard)(Joker *self, struct Card *card);
+  void (*scale_on_blind_select)(Joker *self);
+  void (*scale_passive)(Joker *self);
+} JokerDef;
 
-extern const Joker JOKERS[];
+// Part of joker data which doesn't depend on game state, so it is available to host tools too
+typedef struct {
+  const char *name;
+  Rarity rarity;
+} JokerInfo;
+
+// Both are indexed by JokerId
+extern const JokerDef JOKERS[JOKER_ID_COUNT];
+extern const JokerInfo JOKER_INFO[JOKER_ID_COUNT];
 extern const uint8_t JOKER_COUNT;
 
+Joker create_joker(JokerId id, Edition edition);
+
 #endif
@@ -0,0 +1,19 @@
+#include "joker.h"
+
+const JokerInfo JOKER_INFO[JOKER_ID_COUNT] = {
+    [JOKER_JOKER] = {.name = "Joker", .rarity = RARITY_COMMON},
+    [JOKER_GREEDY] = {.name = "Greedy Joker", .rarity = RARITY_COMMON},
+    [JOKER_LUSTY] = {.name = "Lusty Joker", .rarity = RARITY_COMMON},
+    [JOKER_WRATHFUL] = {.name = "Wrathful Joker", .rarity = RARITY_COMMON},
+    [JOKER_GLUTTONOUS] = {.name = "Gluttonous Joker", .rarity = RARITY_COMMON},
+    [JOKER_JOLLY] = {.name = "Jolly Joker", .rarity = RARITY_COMMON},
+    [JOKER_ZANY] = {.name = "Zany Joker", .rarity = RARITY_COMMON},
+    [JOKER_MAD] = {.name = "Mad Joker", .rarity = RARITY_COMMON},
+    [JOKER_CRAZY] = {.name = "Crazy Joker", .rarity = RARITY_COMMON},
+    [JOKER_DROLL] = {.name = "Droll Joker", .rarity = RARITY_COMMON},
+    [JOKER_SLY] = {.name = "Sly Joker", .rarity = RARITY_COMMON},
+    [JOKER_WILY] = {.name = "Wily Joker", .rarity = RARITY_COMMON},
+    [JOKER_CLEVER] = {.name = "Clever Joker", .rarity = RARITY_COMMON},
+    [JOKER_DEVIOUS] = {.name = "Devious Joker", .rarity = RARITY_COMMON},
+    [JOKER_CRAFTY] = {.name = "Craft Joker", .rarity = RARITY_COMMON},
+};
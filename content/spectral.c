@@ -1,8 +1,9 @@
 #include "spectral.h"
 
+#include "../deck.h"
 #include "../random.h"
 #include "../state.h"
-#include "cvector.h"
+#include "../vector.h"
 
 const char *get_spectral_card_name(Spectral spectral) {
   switch (spectral) {
@@ -106,21 +107,12 @@ uint8_t get_spectral_max_selected(Spectral spectral) {
 void destroy_random_card() {
   if (cvector_size(state.game.hand.cards) == 0) return;
 
-  uint8_t destroy_index = random_vector_index(state.game.hand.cards);
-
-  for (uint8_t i = 0; i < cvector_size(state.game.full_deck); i++) {
-    if (compare_cards(&state.game.full_deck[i], &state.game.hand.cards[destroy_index])) {
-      cvector_erase(state.game.full_deck, i);
-      break;
-    }
-  }
-
-  cvector_erase(state.game.hand.cards, destroy_index);
+  destroy_hand_card(random_vector_index(state.game.hand.cards));
 }
 void add_card_to_deck(Suit suit, Rank rank, Edition edition, Enhancement enhancement, Seal seal) {
   Card card = create_card(suit, rank, edition, enhancement, seal);
+  add_card_to_full_deck(&card);
   cvector_push_back(state.game.hand.cards, card);
-  cvector_push_back(state.game.full_deck, card);
 }
 
 uint8_t use_spectral_card(Spectral spectral) {
@@ -161,11 +153,11 @@ uint8_t use_spectral_card(Spectral spectral) {
       break;
 
     case SPECTRAL_TALISMAN:
-      selected_cards[0]->seal = SEAL_GOLD;
+      transform_cards(selected_cards, 1, transform_set_seal, SEAL_GOLD);
       break;
 
     case SPECTRAL_AURA:
-      selected_cards[0]->edition = random_weighted((uint16_t[3]){50, 35, 15}, 3) + 1;
+      transform_cards(selected_cards, 1, transform_set_edition, random_weighted((uint16_t[3]){50, 35, 15}, 3) + 1);
       break;
 
     case SPECTRAL_WRAITH:
@@ -174,19 +166,7 @@ uint8_t use_spectral_card(Spectral spectral) {
 
     case SPECTRAL_SIGIL: {
       if (state.game.hand.size == 1) return 0;
-      Suit new_suit = random_max_value(3);
-
-      cvector_for_each(state.game.hand.cards, Card, hand_card) {
-        cvector_for_each(state.game.full_deck, Card, card) {
-          if (compare_cards(hand_card, card)) {
-            card->suit = new_suit;
-            card->was_played = 0;
-            hand_card->suit = new_suit;
-            hand_card->was_played = 0;
-            break;
-          }
-        }
-      }
+      transform_hand_cards(transform_set_suit, random_max_value(3));
       break;
     }
 
@@ -195,17 +175,7 @@ uint8_t use_spectral_card(Spectral spectral) {
       Rank new_rank = random_max_value(12);
       state.game.hand.size--;
 
-      cvector_for_each(state.game.hand.cards, Card, hand_card) {
-        cvector_for_each(state.game.full_deck, Card, card) {
-          if (compare_cards(hand_card, card)) {
-            card->rank = new_rank;
-            card->was_played = 0;
-            hand_card->rank = new_rank;
-            hand_card->was_played = 0;
-            break;
-          }
-        }
-      }
+      transform_hand_cards(transform_set_rank, new_rank);
       break;
     }
 
@@ -223,13 +193,13 @@ uint8_t use_spectral_card(Spectral spectral) {
       uint8_t joker_to_copy = random_vector_index(state.game.jokers.cards);
       Joker joker = state.game.jokers.cards[joker_to_copy];
       // TODO Don't remove eternal jokers when they will be added
-      cvector_clear(state.game.jokers.cards);
-      for (uint8_t i = 0; i < 2; i++) cvector_push_back(state.game.jokers.cards, joker);
+      clear_player_jokers();
+      for (uint8_t i = 0; i < 2; i++) add_joker_to_player(&joker);
       break;
     }
 
     case SPECTRAL_DEJA_VU:
-      selected_cards[0]->seal = SEAL_RED;
+      transform_cards(selected_cards, 1, transform_set_seal, SEAL_RED);
       break;
 
     case SPECTRAL_HEX: {
@@ -237,25 +207,25 @@ uint8_t use_spectral_card(Spectral spectral) {
       uint8_t joker_to_upgrade = random_vector_index(state.game.jokers.cards);
       Joker joker = state.game.jokers.cards[joker_to_upgrade];
       // TODO Don't remove eternal jokers when they will be added
-      cvector_clear(state.game.jokers.cards);
+      clear_player_jokers();
 
       joker.edition = EDITION_POLYCHROME;
-      cvector_push_back(state.game.jokers.cards, joker);
+      add_joker_to_player(&joker);
       break;
     }
 
     case SPECTRAL_TRANCE:
-      selected_cards[0]->seal = SEAL_BLUE;
+      transform_cards(selected_cards, 1, transform_set_seal, SEAL_BLUE);
       break;
 
     case SPECTRAL_MEDIUM:
-      selected_cards[0]->seal = SEAL_PURPLE;
+      transform_cards(selected_cards, 1, transform_set_seal, SEAL_PURPLE);
       break;
 
     case SPECTRAL_CRYPTID: {
-      Card *card = selected_cards[0];
-      for (uint8_t i = 0; i < 2; i++)
-        add_card_to_deck(card->suit, card->rank, card->edition, card->enhancement, card->seal);
+      // Copy, as adding cards to hand can reallocate it
+      Card card = *selected_cards[0];
+      for (uint8_t i = 0; i < 2; i++) add_card_to_deck(card.suit, card.rank, card.edition, card.enhancement, card.seal);
       break;
     }
 
@@ -1,8 +1,9 @@
 #include "tarot.h"
 
+#include "../deck.h"
 #include "../random.h"
 #include "../state.h"
-#include "cvector.h"
+#include "../vector.h"
 
 const char *get_tarot_card_name(Tarot tarot) {
   switch (tarot) {
@@ -150,31 +151,11 @@ void tarot_create_consumable(ConsumableType type) {
 }
 
 void tarot_change_enhancement(Card **selected_cards, uint8_t selected_count, Enhancement new_enhancement) {
-  for (uint8_t i = 0; i < selected_count; i++) {
-    cvector_for_each(state.game.full_deck, Card, card) {
-      if (compare_cards(selected_cards[i], card)) {
-        card->enhancement = new_enhancement;
-        card->was_played = 0;
-        selected_cards[i]->enhancement = new_enhancement;
-        selected_cards[i]->was_played = 0;
-        break;
-      }
-    }
-  }
+  transform_cards(selected_cards, selected_count, transform_set_enhancement, new_enhancement);
 }
 
 void tarot_change_suit(Card **selected_cards, uint8_t selected_count, Suit new_suit) {
-  for (uint8_t i = 0; i < selected_count; i++) {
-    cvector_for_each(state.game.full_deck, Card, card) {
-      if (compare_cards(selected_cards[i], card)) {
-        card->suit = new_suit;
-        card->was_played = 0;
-        selected_cards[i]->suit = new_suit;
-        selected_cards[i]->was_played = 0;
-        break;
-      }
-    }
-  }
+  transform_cards(selected_cards, selected_count, transform_set_suit, new_suit);
 }
 
 bool filter_non_edition_jokers(uint8_t i) { return state.game.jokers.cards[i].edition == EDITION_BASE; }
@@ -220,45 +201,41 @@ uint8_t use_tarot_card(Tarot tarot) {
       break;
     }
     case TAROT_STRENGTH:
-      for (uint8_t i = 0; i < selected_count; i++) {
-        cvector_for_each(state.game.full_deck, Card, card) {
-          if (compare_cards(selected_cards[i], card)) {
-            card->rank = (card->rank + 1) % 13;
-            selected_cards[i]->rank = card->rank;
-            break;
-          }
-        }
-      }
+      transform_cards(selected_cards, selected_count, transform_increase_rank, 1);
       break;
-    case TAROT_HANGED_MAN:
-      for (uint8_t i = 0; i < selected_count; i++) {
-        for (size_t j = 0; j < cvector_size(state.game.full_deck); j++) {
-          if (compare_cards(selected_cards[i], &state.game.full_deck[j])) {
-            cvector_erase(state.game.full_deck, j);
-            break;
-          }
-        }
+    case TAROT_HANGED_MAN: {
+      // Erasing from hand invalidates pointers, so destroyed cards are tracked by id
+      uint16_t destroyed_ids[3];
+      for (uint8_t i = 0; i < selected_count; i++) destroyed_ids[i] = selected_cards[i]->id;
 
+      for (uint8_t i = 0; i < selected_count; i++) {
         for (uint8_t j = 0; j < cvector_size(state.game.hand.cards); j++) {
-          if (compare_cards(selected_cards[i], &state.game.hand.cards[j])) {
-            cvector_erase(state.game.hand.cards, j);
+          if (state.game.hand.cards[j].id == destroyed_ids[i]) {
+            destroy_hand_card(j);
             break;
           }
         }
       }
       break;
-    case TAROT_DEATH:
-      cvector_for_each(state.game.full_deck, Card, card) {
-        if (compare_cards(selected_cards[0], card)) {
-          uint8_t is_force_selected = selected_cards[0]->selected == 2;
-          *(selected_cards[0]) = *(selected_cards[1]);
-          if (is_force_selected) selected_cards[0]->selected = 2;
-          *card = *(selected_cards[1]);
-          card->selected = 0;
-          break;
-        }
+    }
+    case TAROT_DEATH: {
+      Card *card = get_full_deck_card(selected_cards[0]->id);
+      uint16_t id = selected_cards[0]->id;
+      uint8_t is_force_selected = selected_cards[0]->selected == 2;
+
+      *(selected_cards[0]) = *(selected_cards[1]);
+      selected_cards[0]->id = id;
+      if (is_force_selected) selected_cards[0]->selected = 2;
+
+      if (card != NULL) {
+        deck_counts_remove(&state.game.full_deck_counts, card);
+        *card = *(selected_cards[1]);
+        card->id = id;
+        card->selected = 0;
+        deck_counts_add(&state.game.full_deck_counts, card);
       }
       break;
+    }
     case TAROT_TEMPERANCE: {
       uint8_t total = 0;
       cvector_for_each(state.game.jokers.cards, Joker, joker) {
@@ -273,10 +250,12 @@ uint8_t use_tarot_card(Tarot tarot) {
       state.game.money += total;
       break;
     }
-    case TAROT_JUDGEMENT:
+    case TAROT_JUDGEMENT: {
       if (cvector_size(state.game.jokers.cards) >= state.game.jokers.size) break;
-      cvector_push_back(state.game.jokers.cards, random_available_joker());
+      Joker joker = random_available_joker();
+      add_joker_to_player(&joker);
       break;
+    }
 
     case TAROT_HIGH_PRIESTESS:
       tarot_create_consumable(CONSUMABLE_PLANET);
@@ -0,0 +1,43 @@
+#include "counters.h"
+
+#include "debug.h"
+
+uint32_t engine_counters[COUNTER_COUNT];
+
+static uint32_t action_start[COUNTER_COUNT];
+
+static const char *counter_names[COUNTER_COUNT] = {
+    [COUNTER_EVALUATE_HAND] = "evaluate_hand",
+    [COUNTER_UPDATE_SCORING_HAND] = "update_scoring_hand",
+    [COUNTER_COMPARE_CARDS] = "compare_cards",
+    [COUNTER_VECTOR_REALLOCATIONS] = "vector reallocations",
+    [COUNTER_JOKER_ON_PLAYED] = "joker on_played",
+    [COUNTER_JOKER_ON_SCORED] = "joker on_scored",
+    [COUNTER_JOKER_ON_HELD] = "joker on_held",
+    [COUNTER_JOKER_INDEPENDENT] = "joker independent",
+    [COUNTER_JOKER_ON_OTHER_JOKERS] = "joker on_other_jokers",
+    [COUNTER_JOKER_ON_DISCARD] = "joker on_discard",
+    [COUNTER_JOKER_ON_BLIND_SELECT] = "joker on_blind_select",
+    [COUNTER_RANDOM_OTHER] = "random other",
+    [COUNTER_RANDOM_SHUFFLE] = "random shuffle",
+    [COUNTER_RANDOM_SHOP] = "random shop",
+    [COUNTER_RANDOM_BOOSTER_PACK] = "random booster pack",
+    [COUNTER_RANDOM_TAG] = "random tag",
+    [COUNTER_RANDOM_BOSS] = "random boss",
+    [COUNTER_RANDOM_EDITION] = "random edition",
+    [COUNTER_RANDOM_ENHANCEMENT] = "random enhancement",
+};
+
+void counters_begin_action() {
+  for (uint8_t i = 0; i < COUNTER_COUNT; i++) action_start[i] = engine_counters[i];
+}
+
+uint32_t get_counter_total(CounterId id) { return engine_counters[id]; }
+
+uint32_t get_counter_action(CounterId id) { return engine_counters[id] - action_start[id]; }
+
+void counters_log() {
+  for (uint8_t i = 0; i < COUNTER_COUNT; i++)
+    log_message(LOG_INFO, "Counter %s: %u total, %u in last action.", counter_names[i], engine_counters[i],
+                engine_counters[i] - action_start[i]);
+}
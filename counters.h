@@ -0,0 +1,46 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdint.h>
+
+// Incrementing a counter is a single add to a global array, so counters stay compiled in every build
+#define COUNTER_INC(id) (engine_counters[id]++)
+#define COUNTER_ADD(id, amount) (engine_counters[id] += (amount))
+
+typedef enum {
+  COUNTER_EVALUATE_HAND,
+  COUNTER_UPDATE_SCORING_HAND,
+  COUNTER_COMPARE_CARDS,
+  COUNTER_VECTOR_REALLOCATIONS,
+
+  // Jokers triggered by TRIGGER_JOKER, each trigger counts once even when joker both scales and activates
+  COUNTER_JOKER_ON_PLAYED,
+  COUNTER_JOKER_ON_SCORED,
+  COUNTER_JOKER_ON_HELD,
+  COUNTER_JOKER_INDEPENDENT,
+  COUNTER_JOKER_ON_OTHER_JOKERS,
+  COUNTER_JOKER_ON_DISCARD,
+  COUNTER_JOKER_ON_BLIND_SELECT,
+
+  // Random draws, in the same order as RandomSubsystem
+  COUNTER_RANDOM_OTHER,
+  COUNTER_RANDOM_SHUFFLE,
+  COUNTER_RANDOM_SHOP,
+  COUNTER_RANDOM_BOOSTER_PACK,
+  COUNTER_RANDOM_TAG,
+  COUNTER_RANDOM_BOSS,
+  COUNTER_RANDOM_EDITION,
+  COUNTER_RANDOM_ENHANCEMENT,
+
+  COUNTER_COUNT
+} CounterId;
+
+extern uint32_t engine_counters[COUNTER_COUNT];
+
+// Starts new player action, counts of the previous one stay readable until the next action
+void counters_begin_action();
+uint32_t get_counter_total(CounterId id);
+uint32_t get_counter_action(CounterId id);
+void counters_log();
+
+#endif
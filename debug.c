@@ -1,55 +1,244 @@
 #include "debug.h"
 
-#ifdef DEBUG_BUILD
+#if defined(DEBUG_BUILD) || defined(TRACE_BUILD)
 
 #include <pspiofilemgr.h>
+#include <pspkernel.h>
+#include <pspthreadman.h>
 #include <stdarg.h>
-#include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
-static const char *LOG_FILENAME = "ms0:/joker_poker_debug.log";
-static const char *LOG_LEVEL_NAMES[] = {"INFO", "WARNING", "ERROR"};
+// Records are written by main thread and stored on memory stick by flush thread whenever main thread waits
+#define TRACE_RING_SIZE (1024)
+#define TRACE_FLUSH_THRESHOLD (TRACE_RING_SIZE / 2)
+#define TRACE_FLUSH_INTERVAL (100000)
+#define TRACE_FLUSH_THREAD_PRIORITY (0x30)
 
-void log_init() {
-  SceUID file = sceIoOpen(LOG_FILENAME, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
-  if (file >= 0) {
-    const char *header = "=== Joker Poker Debug Log ===\n";
-    sceIoWrite(file, header, strlen(header));
-    sceIoClose(file);
+#define TRACE_LOG_MAX_WORDS (3 * TRACE_PAYLOAD_WORDS)
+#define TRACE_MAX_STRING_LENGTH (255)
+#define TRACE_KNOWN_STRING_COUNT (256)
+#define TRACE_OUTPUT_SIZE (4096)
+
+static const char *LOG_FILENAME = "ms0:/joker_poker_trace.bin";
+
+static TraceRecord ring[TRACE_RING_SIZE];
+// Positions only grow, so ring is full when they are TRACE_RING_SIZE records apart
+static volatile uint32_t write_position = 0;
+static volatile uint32_t read_position = 0;
+static volatile uint32_t dropped_count = 0;
+
+static SceUID log_file = -1;
+static SceUID flush_thread = -1;
+static SceUID flush_sema = -1;
+static volatile uint8_t is_flushing = 0;
+
+// Used only by whichever thread flushes, strings are written once per address
+static uint32_t known_strings[TRACE_KNOWN_STRING_COUNT];
+static uint32_t reported_dropped_count = 0;
+static uint8_t output[TRACE_OUTPUT_SIZE];
+static uint16_t output_size = 0;
+
+static void write_output(const void *data, uint16_t size) {
+  if (output_size + size > TRACE_OUTPUT_SIZE) {
+    sceIoWrite(log_file, output, output_size);
+    output_size = 0;
+  }
+
+  memcpy(output + output_size, data, size);
+  output_size += size;
+}
+
+static void write_string(uint32_t address) {
+  uint32_t slot = (address >> 2) % TRACE_KNOWN_STRING_COUNT;
+  for (uint16_t i = 0; known_strings[slot] != 0 && known_strings[slot] != address; i++) {
+    // Table is full, so strings are written again, decoder keeps the latest one per address
+    if (i == TRACE_KNOWN_STRING_COUNT) {
+      memset(known_strings, 0, sizeof(known_strings));
+      break;
+    }
+    slot = (slot + 1) % TRACE_KNOWN_STRING_COUNT;
   }
+  if (known_strings[slot] == address) return;
+  known_strings[slot] = address;
+
+  const char *string = address != 0 ? (const char *)(uintptr_t)address : "(null)";
+  size_t length = strnlen(string, TRACE_MAX_STRING_LENGTH);
+
+  TraceRecord record = {.event = TRACE_EVENT_STRING, .word_count = 2, .payload = {address, length}};
+  write_output(&record, sizeof(record));
+
+  uint8_t padded[TRACE_MAX_STRING_LENGTH + sizeof(TraceRecord)] = {0};
+  memcpy(padded, string, length);
+  for (size_t offset = 0; offset < length; offset += sizeof(TraceRecord))
+    write_output(padded + offset, sizeof(TraceRecord));
+}
+
+static void flush_records() {
+  uint32_t end = write_position;
+  for (uint32_t position = read_position; position != end; position++) {
+    TraceRecord *record = &ring[position % TRACE_RING_SIZE];
+
+    for (uint8_t i = 0; i < record->word_count; i++)
+      if (record->string_mask & (1 << i)) write_string(record->payload[i]);
+
+    write_output(record, sizeof(TraceRecord));
+  }
+  read_position = end;
+
+  // Written after records already in ring, so timestamps in file keep growing
+  if (dropped_count != reported_dropped_count) {
+    TraceRecord record = {.timestamp = sceKernelGetSystemTimeLow(),
+                          .event = TRACE_EVENT_DROPPED,
+                          .word_count = 1,
+                          .payload = {dropped_count - reported_dropped_count}};
+    reported_dropped_count += record.payload[0];
+    write_output(&record, sizeof(record));
+  }
+
+  if (output_size > 0) sceIoWrite(log_file, output, output_size);
+  output_size = 0;
+}
+
+static int flush_thread_entry(SceSize args, void *argp) {
+  while (is_flushing) {
+    SceUInt32 timeout = TRACE_FLUSH_INTERVAL;
+    sceKernelWaitSema(flush_sema, 1, &timeout);
+    flush_records();
+  }
+
+  return 0;
+}
+
+static TraceRecord *reserve_records(uint8_t count) {
+  if (log_file < 0) return NULL;
+  if (write_position - read_position + count > TRACE_RING_SIZE) {
+    dropped_count += count;
+    return NULL;
+  }
+
+  return &ring[write_position % TRACE_RING_SIZE];
+}
+
+static void commit_records(uint8_t count) {
+  // Records have to be complete before flush thread can see them
+  __sync_synchronize();
+  write_position += count;
+
+  if (flush_sema >= 0 && write_position - read_position >= TRACE_FLUSH_THRESHOLD) sceKernelSignalSema(flush_sema, 1);
+}
+
+void log_init() {
+  log_file = sceIoOpen(LOG_FILENAME, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
+  if (log_file < 0) return;
+
+  TraceFileHeader header = {.magic = TRACE_MAGIC, .version = TRACE_VERSION, .record_size = sizeof(TraceRecord)};
+  sceIoWrite(log_file, &header, sizeof(header));
+
+  // Lower priority than main thread, so memory stick writes happen only while it waits for vblank or GPU
+  flush_sema = sceKernelCreateSema("trace_flush_sema", 0, 0, 1, NULL);
+  flush_thread = sceKernelCreateThread("trace_flush_thread", flush_thread_entry, TRACE_FLUSH_THREAD_PRIORITY, 0x4000,
+                                       PSP_THREAD_ATTR_USER, NULL);
+  is_flushing = 1;
+  if (flush_thread >= 0) sceKernelStartThread(flush_thread, 0, NULL);
 }
 
 void log_shutdown() {
-  SceUID file = sceIoOpen(LOG_FILENAME, PSP_O_WRONLY | PSP_O_APPEND, 0777);
-  if (file >= 0) {
-    const char *footer = "\n=== Log Closed ===\n";
-    sceIoWrite(file, footer, strlen(footer));
-    sceIoClose(file);
+  if (log_file < 0) return;
+
+  is_flushing = 0;
+  if (flush_thread >= 0) {
+    sceKernelSignalSema(flush_sema, 1);
+    sceKernelWaitThreadEnd(flush_thread, NULL);
+    sceKernelDeleteThread(flush_thread);
   }
+  if (flush_sema >= 0) sceKernelDeleteSema(flush_sema);
+
+  flush_records();
+  sceIoClose(log_file);
+  log_file = -1;
 }
 
 void log_message(LogLevel level, const char *format, ...) {
-  char buffer[512];
-  char time_str[32];
+  uint32_t words[TRACE_LOG_MAX_WORDS] = {(uint32_t)(uintptr_t)format};
+  uint32_t string_mask = 1;
+  uint8_t word_count = 1;
 
+  // Only argument sizes are taken from format, so it is walked once without producing any text
   va_list args;
   va_start(args, format);
-  vsnprintf(buffer, sizeof(buffer), format, args);
-  va_end(args);
+  for (const char *c = format; *c != '\0' && word_count < TRACE_LOG_MAX_WORDS - 1; c++) {
+    if (*c != '%') continue;
+    c++;
+
+    // strchr also matches terminator, so end of format is checked first
+    while (*c != '\0' && strchr("-+ #0123456789.", *c) != NULL) c++;
 
-  size_t len = strlen(buffer);
-  if (len > 0 && buffer[len - 1] != '\n') {
-    if (len < sizeof(buffer) - 2) {
-      buffer[len] = '\n';
-      buffer[len + 1] = '\0';
+    uint8_t is_long_long = 0;
+    if (*c == 'l' && c[1] == 'l') {
+      is_long_long = 1;
+      c += 2;
+    } else if (*c == 'j') {
+      is_long_long = 1;
+      c++;
+    } else if (*c == 'z') {
+      words[word_count++] = va_arg(args, size_t);
+      c++;
+      continue;
+    } else {
+      while (*c != '\0' && strchr("hlt", *c) != NULL) c++;
     }
+
+    if (*c == '\0') break;
+    if (*c == '%') continue;
+
+    uint64_t value;
+    if (strchr("fFeEgGaA", *c) != NULL) {
+      double number = va_arg(args, double);
+      memcpy(&value, &number, sizeof(value));
+    } else if (is_long_long) {
+      value = va_arg(args, unsigned long long);
+    } else {
+      if (*c == 's') string_mask |= 1 << word_count;
+      words[word_count++] = *c == 's' || *c == 'p' ? (uint32_t)(uintptr_t)va_arg(args, void *)
+                                                    : va_arg(args, unsigned int);
+      continue;
+    }
+
+    words[word_count++] = value;
+    words[word_count++] = value >> 32;
   }
+  va_end(args);
 
-  SceUID file = sceIoOpen(LOG_FILENAME, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_APPEND, 0777);
-  if (file >= 0) {
-    sceIoWrite(file, buffer, strlen(buffer));
-    sceIoClose(file);
+  uint8_t record_count = (word_count + TRACE_PAYLOAD_WORDS - 1) / TRACE_PAYLOAD_WORDS;
+  if (reserve_records(record_count) == NULL) return;
+
+  uint32_t timestamp = sceKernelGetSystemTimeLow();
+  for (uint8_t i = 0; i < record_count; i++) {
+    TraceRecord *record = &ring[(write_position + i) % TRACE_RING_SIZE];
+    uint8_t first_word = i * TRACE_PAYLOAD_WORDS;
+
+    record->timestamp = timestamp;
+    record->event = i == 0 ? TRACE_EVENT_LOG : TRACE_EVENT_LOG_ARGUMENTS;
+    record->level = level;
+    record->string_mask = (string_mask >> first_word) & ((1 << TRACE_PAYLOAD_WORDS) - 1);
+    record->word_count = word_count - first_word < TRACE_PAYLOAD_WORDS ? word_count - first_word : TRACE_PAYLOAD_WORDS;
+    memcpy(record->payload, words + first_word, record->word_count * sizeof(uint32_t));
   }
+
+  commit_records(record_count);
+}
+
+void trace_event(TraceEventId event, uint32_t arg0, uint32_t arg1) {
+  TraceRecord *record = reserve_records(1);
+  if (record == NULL) return;
+
+  *record = (TraceRecord){.timestamp = sceKernelGetSystemTimeLow(),
+                          .event = event,
+                          .level = LOG_INFO,
+                          .word_count = 2,
+                          .payload = {arg0, arg1}};
+  commit_records(1);
 }
 
 #endif
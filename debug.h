@@ -1,18 +1,25 @@
 #ifndef DEBUG_H
 #define DEBUG_H
 
+#include <stdint.h>
+
+#include "trace.h"
+
 typedef enum { LOG_INFO, LOG_WARNING, LOG_ERROR } LogLevel;
 
-#ifdef DEBUG_BUILD
-// Only define functions if in debug mode
+#if defined(DEBUG_BUILD) || defined(TRACE_BUILD)
+// Only define functions if in debug mode or when tracing is requested for profiled build
 void log_init(void);
 void log_shutdown(void);
+// Arguments are recorded without formatting, %s arguments have to point to strings that outlive the flush
 void log_message(LogLevel level, const char *format, ...);
+void trace_event(TraceEventId event, uint32_t arg0, uint32_t arg1);
 #else
 // Empty macros for release builds (compiler will optimize these out)
 #define log_init()
 #define log_shutdown()
 #define log_message(level, format, ...)
+#define trace_event(event, arg0, arg1)
 #endif
 
 #endif
@@ -0,0 +1,121 @@
+#include "deck.h"
+
+#include "debug.h"
+#include "game.h"
+#include "state.h"
+#include "vector.h"
+
+void deck_counts_add(DeckCounts *counts, Card *card) {
+  counts->total++;
+  counts->ranks[card->rank]++;
+  counts->suits[card->suit]++;
+  counts->enhancements[card->enhancement]++;
+  counts->cards[card->suit][card->rank]++;
+
+  if (card->enhancement == ENHANCEMENT_STONE) return;
+  counts->playable_ranks[card->rank]++;
+  if (card->enhancement != ENHANCEMENT_WILD) counts->natural_suits[card->suit]++;
+}
+
+void deck_counts_remove(DeckCounts *counts, Card *card) {
+  counts->total--;
+  counts->ranks[card->rank]--;
+  counts->suits[card->suit]--;
+  counts->enhancements[card->enhancement]--;
+  counts->cards[card->suit][card->rank]--;
+
+  if (card->enhancement == ENHANCEMENT_STONE) return;
+  counts->playable_ranks[card->rank]--;
+  if (card->enhancement != ENHANCEMENT_WILD) counts->natural_suits[card->suit]--;
+}
+
+void reset_deck() {
+  cvector_copy(state.game.full_deck, state.game.deck);
+  state.game.deck_counts = state.game.full_deck_counts;
+}
+
+void add_card_to_full_deck(Card *card) {
+  size_t id = cvector_size(state.game.full_deck_index);
+  if (id >= CARD_INDEX_REMOVED) {
+    log_message(LOG_ERROR, "Card id space exhausted, card was not added to the deck.");
+    return;
+  }
+
+  card->id = id;
+  cvector_push_back(state.game.full_deck_index, cvector_size(state.game.full_deck));
+  cvector_push_back(state.game.full_deck, *card);
+  deck_counts_add(&state.game.full_deck_counts, card);
+}
+
+Card *get_full_deck_card(uint16_t id) {
+  if (id >= cvector_size(state.game.full_deck_index)) return NULL;
+
+  uint16_t index = state.game.full_deck_index[id];
+  if (index == CARD_INDEX_REMOVED) return NULL;
+
+  return &state.game.full_deck[index];
+}
+
+void remove_card_from_full_deck(uint16_t id) {
+  if (id >= cvector_size(state.game.full_deck_index)) return;
+
+  uint16_t index = state.game.full_deck_index[id];
+  if (index == CARD_INDEX_REMOVED) return;
+
+  deck_counts_remove(&state.game.full_deck_counts, &state.game.full_deck[index]);
+
+  // Swap with the last card instead of shifting whole tail of the deck
+  size_t last = cvector_size(state.game.full_deck) - 1;
+  if (index != last) {
+    state.game.full_deck[index] = state.game.full_deck[last];
+    state.game.full_deck_index[state.game.full_deck[index].id] = index;
+  }
+
+  cvector_pop_back(state.game.full_deck);
+  state.game.full_deck_index[id] = CARD_INDEX_REMOVED;
+}
+
+void destroy_hand_card(uint8_t index) {
+  remove_card_from_full_deck(state.game.hand.cards[index].id);
+  cvector_erase(state.game.hand.cards, index);
+}
+
+static void transform_card(Card *card, CardTransform transform, uint8_t value) {
+  transform(card, value);
+
+  Card *deck_card = get_full_deck_card(card->id);
+  if (deck_card == NULL || deck_card == card) return;
+
+  deck_counts_remove(&state.game.full_deck_counts, deck_card);
+  transform(deck_card, value);
+  deck_counts_add(&state.game.full_deck_counts, deck_card);
+}
+
+void transform_cards(Card **cards, uint8_t count, CardTransform transform, uint8_t value) {
+  for (uint8_t i = 0; i < count; i++) transform_card(cards[i], transform, value);
+}
+
+void transform_hand_cards(CardTransform transform, uint8_t value) {
+  cvector_for_each(state.game.hand.cards, Card, card) transform_card(card, transform, value);
+}
+
+void transform_set_suit(Card *card, uint8_t suit) {
+  card->suit = suit;
+  card->was_played = 0;
+}
+
+void transform_set_rank(Card *card, uint8_t rank) {
+  card->rank = rank;
+  card->was_played = 0;
+}
+
+void transform_increase_rank(Card *card, uint8_t amount) { card->rank = (card->rank + amount) % 13; }
+
+void transform_set_enhancement(Card *card, uint8_t enhancement) {
+  card->enhancement = enhancement;
+  card->was_played = 0;
+}
+
+void transform_set_edition(Card *card, uint8_t edition) { card->edition = edition; }
+
+void transform_set_seal(Card *card, uint8_t seal) { card->seal = seal; }
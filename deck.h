@@ -0,0 +1,34 @@
+#ifndef DECK_H
+#define DECK_H
+
+#include <stdint.h>
+
+#include "game.h"
+
+// Index map value of cards that were destroyed
+#define CARD_INDEX_REMOVED UINT16_MAX
+
+typedef void (*CardTransform)(Card *card, uint8_t value);
+
+void deck_counts_add(DeckCounts *counts, Card *card);
+void deck_counts_remove(DeckCounts *counts, Card *card);
+
+void reset_deck();
+
+void add_card_to_full_deck(Card *card);
+Card *get_full_deck_card(uint16_t id);
+void remove_card_from_full_deck(uint16_t id);
+void destroy_hand_card(uint8_t index);
+
+// Applies transform to given hand cards and their full deck counterparts
+void transform_cards(Card **cards, uint8_t count, CardTransform transform, uint8_t value);
+void transform_hand_cards(CardTransform transform, uint8_t value);
+
+void transform_set_suit(Card *card, uint8_t suit);
+void transform_set_rank(Card *card, uint8_t rank);
+void transform_increase_rank(Card *card, uint8_t amount);
+void transform_set_enhancement(Card *card, uint8_t enhancement);
+void transform_set_edition(Card *card, uint8_t edition);
+void transform_set_seal(Card *card, uint8_t seal);
+
+#endif
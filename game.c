@@ -1,36 +1,53 @@
 #include "game.h"
 
-#include <cvector.h>
 #include <math.h>
 #include <stdint.h>
 
 #include "content/joker.h"
 #include "content/spectral.h"
 #include "content/tarot.h"
+#include "counters.h"
 #include "debug.h"
+#include "deck.h"
 #include "random.h"
+#include "roll.h"
+#include "save.h"
 #include "state.h"
 #include "utils.h"
+#include "vector.h"
 
-void game_init(Deck deck, Stake stake) {
-  rng_init();
+void game_init(Deck deck, Stake stake, uint32_t seed) {
+  // Deck, tags and boss blind are rolled below, so seed has to be set first
+  set_random_seed(seed);
+  state.game.seed = seed;
+
+  arena_init(&state.game.run_arena, "Run", RUN_ARENA_CAPACITY);
+  arena_init(&state.game.shop_arena, "Shop", SHOP_ARENA_CAPACITY);
+  set_vector_arena(&state.game.run_arena);
 
   state.game.deck_type = deck;
   state.game.stake = stake;
 
+  memset(&state.game.full_deck_counts, 0, sizeof(DeckCounts));
   generate_deck();
 
-  state.game.score = 0;
+  state.game.score = score_from_double(0);
   state.game.ante = 1;
   state.game.round = 0;
 
+  // Tags and boss blind depend on these (see RollContext), so they can't be left over from the previous run
+  state.game.vouchers = 0;
+  memset(state.game.jokers.owned, 0, sizeof(state.game.jokers.owned));
+  state.game.played_poker_hands = 0;
+  state.game.defeated_boss_blinds = 0b11;
+  memset(state.game.poker_hands, 0, 12 * sizeof(PokerHandStats));
+
   state.game.blinds[0] = (Blind){.type = BLIND_SMALL, .tag = roll_tag(), .is_active = 1};
   state.game.blinds[1] = (Blind){.type = BLIND_BIG, .tag = roll_tag(), .is_active = 1};
   state.game.blinds[2] = (Blind){.is_active = 1};
   roll_boss_blind();
 
   state.game.current_blind = &state.game.blinds[0];
-  state.game.vouchers = 0;
 
   state.game.money = 4;
 
@@ -54,32 +71,40 @@ void game_init(Deck deck, Stake stake) {
   change_stage(STAGE_SELECT_BLIND);
 
   state.game.fool_last_used.was_used = 0;
-  state.game.played_poker_hands = 0;
-  state.game.defeated_boss_blinds = 0b11;
   state.game.has_rerolled_boss = 0;
-  memset(state.game.poker_hands, 0, 12 * sizeof(PokerHandStats));
 
-  cvector_reserve(state.game.shop.booster_packs, 2);
+  reset_shop_arena();
 
-  cvector_copy(state.game.full_deck, state.game.deck);
+  reset_deck();
   cvector_reserve(state.game.hand.cards, state.game.hand.size);
 
   memset(&state.game.stats, 0, sizeof(Stats));
 
-  log_message(LOG_INFO, "Game has been initialized.");
+  log_message(LOG_INFO, "Game has been initialized with seed %08X.", state.game.seed);
 }
 
 void game_destroy() {
-  cvector_destroy(state.game.deck);
-  cvector_destroy(state.game.full_deck);
-  cvector_destroy(state.game.hand.cards);
-  cvector_destroy(state.game.jokers.cards);
-  cvector_destroy(state.game.consumables.items);
-  cvector_destroy(state.game.shop.items);
-  cvector_destroy(state.game.shop.booster_packs);
-  cvector_destroy(state.game.booster_pack.content);
-  cvector_destroy(state.game.shop.vouchers);
-  cvector_destroy(state.game.tags);
+  // Game was not initialized or has already been destroyed
+  if (state.game.run_arena.name == NULL) return;
+
+  arena_log_usage(&state.game.run_arena);
+  arena_log_usage(&state.game.shop_arena);
+
+  // Every vector is allocated from one of the arenas, so they are all released at once
+  arena_destroy(&state.game.run_arena);
+  arena_destroy(&state.game.shop_arena);
+
+  state.game.deck = NULL;
+  state.game.full_deck = NULL;
+  state.game.full_deck_index = NULL;
+  state.game.hand.cards = NULL;
+  state.game.jokers.cards = NULL;
+  state.game.consumables.items = NULL;
+  state.game.shop.items = NULL;
+  state.game.shop.booster_packs = NULL;
+  state.game.booster_pack.content = NULL;
+  state.game.shop.vouchers = NULL;
+  state.game.tags = NULL;
 
   log_message(LOG_INFO, "Game has been destroyed.");
 }
@@ -101,7 +126,8 @@ void generate_deck() {
       suit = random_max_value(3);
     }
 
-    cvector_push_back(state.game.full_deck, create_card(suit, rank, EDITION_BASE, ENHANCEMENT_NONE, SEAL_NONE));
+    Card card = create_card(suit, rank, EDITION_BASE, ENHANCEMENT_NONE, SEAL_NONE);
+    add_card_to_full_deck(&card);
   }
 }
 
@@ -155,8 +181,8 @@ void apply_deck_settings() {
 }
 
 uint8_t compare_cards(Card *a, Card *b) {
-  return a->chips == b->chips && a->enhancement == b->enhancement && a->edition == b->edition && a->rank == b->rank &&
-         a->suit == b->suit && a->seal == b->seal && a->was_played == b->was_played;
+  COUNTER_INC(COUNTER_COMPARE_CARDS);
+  return a->id == b->id;
 }
 
 Card create_card(Suit suit, Rank rank, Edition edition, Enhancement enhancement, Seal seal) {
@@ -173,6 +199,7 @@ Card create_card(Suit suit, Rank rank, Edition edition, Enhancement enhancement,
 }
 
 void draw_card() {
+  deck_counts_remove(&state.game.deck_counts, &cvector_back(state.game.deck));
   cvector_push_back(state.game.hand.cards, cvector_back(state.game.deck));
   cvector_pop_back(state.game.deck);
 
@@ -271,7 +298,7 @@ void play_hand() {
         break;
       case BLIND_FLINT:
         state.game.selected_hand.score_pair.mult /= 2;
-        state.game.selected_hand.score_pair.chips /= 2;
+        state.game.selected_hand.score_pair.chips = floor(state.game.selected_hand.score_pair.chips / 2);
         break;
       default:
         break;
@@ -330,35 +357,30 @@ void play_hand() {
     }
   }
 
-  if (state.game.deck_type == DECK_PLASMA)
-    state.game.score +=
-        pow(floor((state.game.selected_hand.score_pair.chips + state.game.selected_hand.score_pair.mult) / 2), 2);
-  else
-    state.game.score += state.game.selected_hand.score_pair.chips * state.game.selected_hand.score_pair.mult;
+  if (state.game.deck_type == DECK_PLASMA) {
+    double balanced =
+        floor((state.game.selected_hand.score_pair.chips + state.game.selected_hand.score_pair.mult) / 2);
+    state.game.score = score_add(state.game.score, score_from_product(balanced, balanced));
+  } else {
+    state.game.score = score_add(state.game.score, score_from_product(state.game.selected_hand.score_pair.chips,
+                                                                      state.game.selected_hand.score_pair.mult));
+  }
 
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_ENHANCEMENT);
   for (uint8_t i = 0; i < 5; i++) {
     Card *card = state.game.selected_hand.scoring_cards[i];
     if (card == NULL || card->status & CARD_STATUS_DEBUFFED || card->enhancement != ENHANCEMENT_GLASS) continue;
 
-    if (random_chance(1, 4)) {
-      for (uint8_t i = 0; i < cvector_size(state.game.full_deck); i++) {
-        Card *other = &state.game.full_deck[i];
-        if (compare_cards(card, other)) {
-          cvector_erase(state.game.full_deck, i);
-          break;
-        }
-      }
-    }
+    if (random_chance(1, 4)) remove_card_from_full_deck(card->id);
   }
+  set_random_subsystem(previous_subsystem);
 
   if (state.game.current_blind->type <= BLIND_BIG) {
     cvector_for_each(state.game.hand.cards, Card, card) {
-      cvector_for_each(state.game.full_deck, Card, deck_card) {
-        if (card->selected > 0 && compare_cards(card, deck_card)) {
-          deck_card->was_played = 1;
-          break;
-        }
-      }
+      if (card->selected == 0) continue;
+
+      Card *deck_card = get_full_deck_card(card->id);
+      if (deck_card != NULL) deck_card->was_played = 1;
     }
   }
 
@@ -366,9 +388,9 @@ void play_hand() {
   remove_selected_cards();
   state.game.hands.remaining--;
 
-  double required_score = get_required_score(state.game.ante, state.game.current_blind->type);
+  BigScore required_score = get_required_score(state.game.ante, state.game.current_blind->type);
 
-  if (state.game.score >= required_score) {
+  if (score_compare(state.game.score, required_score) >= 0) {
     cvector_for_each(state.game.hand.cards, Card, card) {
       if (card->status & CARD_STATUS_DEBUFFED) continue;
 
@@ -416,7 +438,7 @@ void cash_out() {
   state.game.money += get_interest_money() + get_hands_money() + get_discards_money() +
                       get_blind_money(state.game.current_blind->type) + get_investment_tag_money();
 
-  state.game.score = 0;
+  state.game.score = score_from_double(0);
   state.game.played_poker_hands = 0;
 
   for (int8_t i = 0; i < cvector_size(state.game.tags); i++) {
@@ -433,6 +455,7 @@ void cash_out() {
     state.game.defeated_boss_blinds |= 1 << state.game.current_blind->type;
 
     state.game.ante++;
+    advance_random_streams(state.game.ante);
     state.game.has_rerolled_boss = 0;
 
     for (int8_t i = 0; i < cvector_size(state.game.tags); i++) {
@@ -459,10 +482,11 @@ void cash_out() {
   state.game.hands.remaining = state.game.hands.total;
   state.game.discards.remaining = state.game.discards.total;
   cvector_clear(state.game.hand.cards);
-  cvector_copy(state.game.full_deck, state.game.deck);
+  reset_deck();
 
   change_stage(STAGE_SHOP);
   restock_shop();
+  save_game();
 }
 
 static void apply_scoring_enhancement(Enhancement enhancement) {
@@ -485,10 +509,13 @@ static void apply_scoring_enhancement(Enhancement enhancement) {
     case ENHANCEMENT_STONE:
       state.game.selected_hand.score_pair.chips += 50;
       break;
-    case ENHANCEMENT_LUCKY:
+    case ENHANCEMENT_LUCKY: {
+      RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_ENHANCEMENT);
       if (random_chance(1, 5)) state.game.selected_hand.score_pair.mult += 20;
       if (random_chance(1, 15)) state.game.money += 20;
+      set_random_subsystem(previous_subsystem);
       break;
+    }
   }
 }
 
@@ -596,9 +623,26 @@ uint8_t is_poker_hand_unknown() {
 bool is_planet_card_locked(Planet planet) { return planet <= PLANET_X && state.game.poker_hands[planet].played == 0; }
 bool filter_locked_planet_cards(uint8_t planet) { return !is_planet_card_locked(planet); }
 
+uint32_t get_unlocked_planets() {
+  uint32_t planets = (1u << (PLANET_PLUTO + 1)) - 1;
+  for (Planet planet = 0; planet <= PLANET_X; planet++)
+    if (is_planet_card_locked(planet)) planets &= ~(1u << planet);
+
+  return planets;
+}
+
 void shuffle_deck() {
-  for (uint8_t i = cvector_size(state.game.deck) - 1; i > 0; i--) {
-    uint8_t j = rand() % (i + 1);
+  uint8_t deck_size = cvector_size(state.game.deck);
+  if (deck_size < 2) return;
+
+  // Draws are generated in one batch, gives the same order as drawing them one by one
+  uint32_t draws[deck_size - 1];
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_SHUFFLE);
+  random_fill(draws, deck_size - 1);
+  set_random_subsystem(previous_subsystem);
+
+  for (uint8_t i = deck_size - 1; i > 0; i--) {
+    uint8_t j = random_draw_scaled(draws[deck_size - 1 - i], i);
     Card temp = state.game.deck[i];
     state.game.deck[i] = state.game.deck[j];
     state.game.deck[j] = temp;
@@ -671,68 +715,81 @@ void sort_hand() {
 }
 
 uint16_t evaluate_hand() {
-  const Hand *hand = &state.game.hand;
+  COUNTER_INC(COUNTER_EVALUATE_HAND);
 
-  uint16_t result = HAND_HIGH_CARD;
+  HandHistogram histogram = {0};
+  cvector_for_each(state.game.hand.cards, Card, card) {
+    if (card->selected != 0) add_histogram_card(&histogram, to_histogram_card(card));
+  }
 
-  uint8_t rank_counts[13] = {};
-  uint8_t suit_counts[4] = {};
-  const uint8_t selected_count = state.game.selected_hand.count;
+  // At most 5 cards are selected, so flush takes all of them and suited hands can be read from the same histogram
+  uint16_t result = get_histogram_hands(&histogram);
+  if (result & HAND_FLUSH) result |= get_suited_histogram_hands(&histogram);
 
-  // 2 of kind, 3 of kind, 4 of kind, 5 of kind
-  uint8_t x_of_kind[4] = {};
-  uint8_t is_straight_possible = 1;
-  uint8_t has_ace = 0;
+  return result;
+}
 
-  Rank highest_card = RANK_TWO, lowest_card = RANK_KING;
+HistogramCard to_histogram_card(const Card *card) {
+  if (card->enhancement == ENHANCEMENT_STONE) return (HistogramCard){0};
 
-  cvector_for_each(hand->cards, Card, card) {
-    if (card->selected == 0 || card->enhancement == ENHANCEMENT_STONE) continue;
+  uint32_t suit_lanes = card->enhancement == ENHANCEMENT_WILD ? 0x01010101u : 1u << (8 * card->suit);
+  return (HistogramCard){.rank_bit = 1 << card->rank, .suit_lanes = suit_lanes};
+}
 
-    if (card->rank == RANK_ACE) has_ace = 1;
-    if (card->rank != RANK_ACE && card->rank > highest_card) highest_card = card->rank;
-    if (card->rank != RANK_ACE && card->rank < lowest_card) lowest_card = card->rank;
+void add_histogram_card(HandHistogram *histogram, HistogramCard card) {
+  uint16_t *planes = histogram->rank_planes;
+  planes[4] |= planes[3] & card.rank_bit;
+  planes[3] |= planes[2] & card.rank_bit;
+  planes[2] |= planes[1] & card.rank_bit;
+  planes[1] |= planes[0] & card.rank_bit;
+  planes[0] |= card.rank_bit;
 
-    rank_counts[card->rank]++;
+  histogram->suit_counts += card.suit_lanes;
+}
 
-    if (card->enhancement == ENHANCEMENT_WILD)
-      for (uint8_t i = 0; i < 4; i++) suit_counts[i]++;
-    else
-      suit_counts[card->suit]++;
-
-    if (rank_counts[card->rank] > 1) {
-      // this means there are duplicates in selected ranks,
-      // so straight is not possible
-      is_straight_possible = 0;
-      x_of_kind[rank_counts[card->rank] - 2]++;
-      if (rank_counts[card->rank] > 2) x_of_kind[rank_counts[card->rank] - 3]--;
-    }
-  }
+uint16_t get_histogram_hands(const HandHistogram *histogram) {
+  const uint16_t *planes = histogram->rank_planes;
+  uint16_t result = HAND_HIGH_CARD;
 
-  for (uint8_t i = 0; i < 4; i++)
-    if (suit_counts[i] == 5) result |= HAND_FLUSH;
+  // Clearing the lowest bit leaves some only when there are at least two of them
+  if (planes[1] != 0) result |= HAND_PAIR;
+  if ((planes[1] & (planes[1] - 1)) != 0) result |= HAND_TWO_PAIR;
+  if (planes[2] != 0) result |= HAND_THREE_OF_KIND;
+  if (planes[2] != 0 && (planes[1] & (planes[1] - 1)) != 0) result |= HAND_FULL_HOUSE;
+  if (planes[3] != 0) result |= HAND_FOUR_OF_KIND;
+  if (planes[4] != 0) result |= HAND_FIVE_OF_KIND;
 
-  // A 2 3 4 5 is also valid straight, so it needs to be checked
-  if (is_straight_possible == 1 && selected_count == 5 &&
-      ((has_ace == 0 && highest_card - lowest_card == 4) ||
-       (has_ace == 1 && (13 - lowest_card == 4 || highest_card == 4))))
-    result |= HAND_STRAIGHT;
+  // Ace is also placed above King, so 10 J Q K A is also valid straight
+  uint16_t ranks = planes[0] | (planes[0] & 1) << 13;
+  if (ranks & ranks >> 1 & ranks >> 2 & ranks >> 3 & ranks >> 4) result |= HAND_STRAIGHT;
 
-  for (uint8_t i = 2; i <= 5; i++) {
-    if (x_of_kind[i - 2] == 0) continue;
+  if (get_flush_suit_lanes(histogram) != 0) result |= HAND_FLUSH;
+  return result;
+}
+
+// Adding 123 carries into the top bit of a lane exactly when it holds at least 5 cards, lanes never hold 133 of them
+uint32_t get_flush_suit_lanes(const HandHistogram *histogram) {
+  return (histogram->suit_counts + 0x7B7B7B7Bu) >> 7 & 0x01010101u;
+}
+
+void evaluate_histogram_batch(const HandHistogram *base, const HistogramCard *cards, const uint16_t *drawn,
+                              uint8_t draw_count, uint8_t sample_count, uint16_t *results) {
+  for (uint8_t sample = 0; sample < sample_count; sample++) {
+    const uint16_t *sample_drawn = &drawn[sample * draw_count];
 
-    if (i >= 2) result |= HAND_PAIR;
-    if (i >= 3) result |= HAND_THREE_OF_KIND;
-    if (i >= 4) result |= HAND_FOUR_OF_KIND;
-    if (i >= 5) result |= HAND_FIVE_OF_KIND;
+    HandHistogram histogram = *base;
+    for (uint8_t i = 0; i < draw_count; i++) add_histogram_card(&histogram, cards[sample_drawn[i]]);
+    results[sample] = get_histogram_hands(&histogram);
   }
+}
 
-  if (x_of_kind[2 - 2] >= 2) result |= HAND_TWO_PAIR;
-  if (x_of_kind[3 - 2] == 1 && x_of_kind[2 - 2] == 1) result |= HAND_TWO_PAIR | HAND_FULL_HOUSE;
+uint16_t get_suited_histogram_hands(const HandHistogram *suited) {
+  uint16_t hands = get_histogram_hands(suited);
+  uint16_t result = 0;
 
-  if ((result & HAND_FLUSH) != 0 && (result & HAND_STRAIGHT) != 0) result |= HAND_STRAIGHT_FLUSH;
-  if ((result & HAND_FLUSH) != 0 && (result & HAND_FULL_HOUSE) != 0) result |= HAND_FLUSH_HOUSE;
-  if ((result & HAND_FLUSH) != 0 && (result & HAND_FIVE_OF_KIND) != 0) result |= HAND_FLUSH_FIVE;
+  if (hands & HAND_STRAIGHT) result |= HAND_STRAIGHT_FLUSH;
+  if (hands & HAND_FULL_HOUSE) result |= HAND_FLUSH_HOUSE;
+  if (hands & HAND_FIVE_OF_KIND) result |= HAND_FLUSH_FIVE;
 
   return result;
 }
@@ -745,6 +802,7 @@ uint8_t does_poker_hand_contain(uint16_t hand_union, PokerHand expected) {
 PokerHand get_poker_hand(uint16_t hand_union) { return 1 << (ffs(hand_union) - 1); }
 
 void update_scoring_hand() {
+  COUNTER_INC(COUNTER_UPDATE_SCORING_HAND);
   uint16_t hand_union = evaluate_hand();
 
   state.game.selected_hand.hand_union = hand_union;
@@ -906,7 +964,7 @@ ScorePair get_poker_hand_total_score(uint16_t hand_union) {
   return poker_hand_score;
 }
 
-double get_ante_base_score(uint8_t ante) {
+static double get_ante_base_score_table(uint8_t ante) {
   if (state.game.stake >= STAKE_PURPLE) {
     switch (ante) {
       case 0:
@@ -977,25 +1035,42 @@ double get_ante_base_score(uint8_t ante) {
   return 0;
 }
 
-double get_required_score(uint8_t ante, BlindType blind_type) {
-  double base_score = (state.game.deck_type == DECK_PLASMA ? 2 : 1) * get_ante_base_score(ante);
+BigScore get_ante_base_score(uint8_t ante) {
+  if (ante <= 8) return score_from_double(get_ante_base_score_table(ante));
+
+  // Endless mode scaling: base * (1.6 + (0.75 * c)^(1 + 0.2 * c))^c, evaluated in log space
+  // and rounded down to two significant digits
+  double c = ante - 8;
+  double amount = log10(get_ante_base_score_table(8)) + c * log10(1.6 + pow(0.75 * c, 1 + 0.2 * c));
+  double magnitude = floor(amount) - 1;
+  return score_from_log10(magnitude + log10(floor(pow(10, amount - magnitude))));
+}
+
+BigScore get_required_score(uint8_t ante, BlindType blind_type) {
+  double multiplier = state.game.deck_type == DECK_PLASMA ? 2 : 1;
 
   switch (blind_type) {
     case BLIND_SMALL:
-      return base_score;
+      break;
     case BLIND_BIG:
-      return 1.5 * base_score;
+      multiplier *= 1.5;
+      break;
 
     case BLIND_WALL:
-      return (state.game.current_blind->is_active ? 4.0 : 2.0) * base_score;
+      multiplier *= state.game.current_blind->is_active ? 4.0 : 2.0;
+      break;
     case BLIND_NEEDLE:
-      return base_score;
+      break;
     case BLIND_VIOLET_VESSEL:
-      return (state.game.current_blind->is_active ? 6.0 : 2.0) * base_score;
+      multiplier *= state.game.current_blind->is_active ? 6.0 : 2.0;
+      break;
 
     default:
-      return 2.0 * base_score;
+      multiplier *= 2.0;
+      break;
   }
+
+  return score_scale(get_ante_base_score(ante), multiplier);
 }
 
 uint8_t get_blind_money(BlindType blind_type) {
@@ -1078,11 +1153,11 @@ uint8_t add_item_to_player(ShopItem *item) {
     case SHOP_ITEM_JOKER:
       if (cvector_size(state.game.jokers.cards) >= state.game.jokers.size) return 0;
 
-      cvector_push_back(state.game.jokers.cards, item->joker);
+      add_joker_to_player(&item->joker);
       break;
 
     case SHOP_ITEM_CARD:
-      cvector_push_back(state.game.full_deck, item->card);
+      add_card_to_full_deck(&item->card);
       break;
 
     case SHOP_ITEM_PLANET:
@@ -1138,6 +1213,29 @@ static uint8_t get_edition_cost(Edition edition) {
   }
 }
 
+void add_joker_to_player(Joker *joker) {
+  cvector_push_back(state.game.jokers.cards, *joker);
+  state.game.jokers.owned[joker->id / 32] |= 1u << (joker->id % 32);
+}
+
+void remove_joker_from_player(uint8_t index) {
+  JokerId id = state.game.jokers.cards[index].id;
+  cvector_erase(state.game.jokers.cards, index);
+
+  // Copies made by Ankh share id, so it stays owned until the last of them is gone
+  state.game.jokers.owned[id / 32] &= ~(1u << (id % 32));
+  cvector_for_each(state.game.jokers.cards, Joker, joker) {
+    if (joker->id == id) state.game.jokers.owned[id / 32] |= 1u << (id % 32);
+  }
+}
+
+void clear_player_jokers() {
+  cvector_clear(state.game.jokers.cards);
+  memset(state.game.jokers.owned, 0, sizeof(state.game.jokers.owned));
+}
+
+bool is_joker_owned(JokerId id) { return state.game.jokers.owned[id / 32] & (1u << (id % 32)); }
+
 uint8_t get_shop_item_price(ShopItem *item) {
   if (item->is_free) return 0;
 
@@ -1154,7 +1252,7 @@ uint8_t get_shop_item_price(ShopItem *item) {
       price = 4;
       break;
     case SHOP_ITEM_JOKER:
-      price = item->joker.base_price + get_edition_cost(item->joker.edition);
+      price = JOKERS[item->joker.id].base_price + get_edition_cost(item->joker.edition);
       break;
   }
 
@@ -1172,7 +1270,9 @@ void add_voucher_to_player(Voucher voucher) {
     case VOUCHER_OVERSTOCK:
     case VOUCHER_OVERSTOCK_PLUS:
       state.game.shop.size++;
+      RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_SHOP);
       fill_shop_items();
+      set_random_subsystem(previous_subsystem);
       break;
     case VOUCHER_CRYSTAL_BALL:
       state.game.consumables.size++;
@@ -1211,11 +1311,6 @@ uint8_t get_booster_pack_price(BoosterPackItem *booster_pack) {
   if (booster_pack->is_free) return 0;
   return apply_sale(4 + booster_pack->size * 2);
 }
-uint8_t get_booster_pack_items_count(BoosterPackItem *booster_pack) {
-  uint8_t count = booster_pack->size == BOOSTER_PACK_NORMAL ? 3 : 5;
-  if (booster_pack->type == BOOSTER_PACK_BUFFOON) count--;
-  return count;
-}
 
 uint8_t get_shop_item_sell_price(ShopItem *item) {
   uint8_t sell_price = (uint8_t)floorf(get_shop_item_price(item) / 2.0);
@@ -1263,6 +1358,7 @@ static bool buy_shop_item(uint8_t index, bool should_use) {
   }
 
   cvector_erase(state.game.shop.items, index);
+  update_offered_items(&state.game.shop.offered, state.game.shop.items);
   return true;
 }
 
@@ -1332,7 +1428,7 @@ void sell_shop_item() {
   } else {
     item.type = SHOP_ITEM_JOKER;
     item.joker = state.game.jokers.cards[item_index];
-    cvector_erase(state.game.jokers.cards, item_index);
+    remove_joker_from_player(item_index);
 
     if (state.stage == STAGE_GAME && state.game.current_blind->is_active &&
         state.game.current_blind->type == BLIND_VERDANT_LEAF)
@@ -1343,27 +1439,44 @@ void sell_shop_item() {
   set_nav_hovered(item_index);
 }
 
-#define FILTER_AVAILABLE_ITEMS(vec, expected_type, item_type)                        \
-  do {                                                                               \
-    cvector_for_each(vec, ShopItem, item) {                                          \
-      if (item->type == expected_type && item->item_type == item_type) return false; \
-    }                                                                                \
-    return true;                                                                     \
-  } while (0);
+void update_offered_items(OfferedItems *offered, cvector_vector_type(ShopItem) items) {
+  *offered = (OfferedItems){0};
+  cvector_for_each(items, ShopItem, item) offer_item(offered, item);
+}
 
-static bool filter_available_tarot_booster_pack(uint8_t tarot) {
-  FILTER_AVAILABLE_ITEMS(state.game.booster_pack.content, SHOP_ITEM_TAROT, tarot);
+static RollContext get_roll_context() {
+  return (RollContext){.ante = state.game.ante,
+                       .vouchers = state.game.vouchers,
+                       .deck_type = state.game.deck_type,
+                       .defeated_boss_blinds = state.game.defeated_boss_blinds,
+                       .owned_jokers = state.game.jokers.owned,
+                       .unlocked_planets = get_unlocked_planets(),
+                       .most_played_planet = ffs(get_most_played_poker_hand()) - 1};
 }
-static bool filter_available_planet_booster_pack(uint8_t planet) {
-  if (is_planet_card_locked(planet)) return false;
-  FILTER_AVAILABLE_ITEMS(state.game.booster_pack.content, SHOP_ITEM_PLANET, planet);
+
+// Fills in fields which picked items leave out
+static ShopItem create_picked_item(ShopItem item) {
+  if (item.type == SHOP_ITEM_JOKER) item.joker = create_joker(item.joker.id, item.joker.edition);
+  if (item.type == SHOP_ITEM_CARD)
+    item.card = create_card(item.card.suit, item.card.rank, item.card.edition, item.card.enhancement, item.card.seal);
+
+  return item;
 }
-static bool filter_available_spectral_booster_pack(uint8_t spectral) {
-  FILTER_AVAILABLE_ITEMS(state.game.booster_pack.content, SHOP_ITEM_SPECTRAL, spectral);
+
+Joker random_available_joker() {
+  RollContext context = get_roll_context();
+  return create_picked_item(pick_joker(&context)).joker;
+}
+
+Joker random_available_joker_by_rarity(Rarity rarity) {
+  RollContext context = get_roll_context();
+  return create_picked_item(pick_joker_by_rarity(&context, rarity)).joker;
 }
 
 void open_booster_pack(BoosterPackItem *booster_pack) {
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_BOOSTER_PACK);
   cvector_clear(state.game.booster_pack.content);
+  state.game.booster_pack.offered = (OfferedItems){0};
   state.game.booster_pack.item = *booster_pack;
   state.game.booster_pack.uses = booster_pack->size == BOOSTER_PACK_MEGA ? 2 : 1;
 
@@ -1373,51 +1486,21 @@ void open_booster_pack(BoosterPackItem *booster_pack) {
   fill_hand();
   sort_hand();
 
+  RollContext context = get_roll_context();
   for (uint8_t i = 0; i < get_booster_pack_items_count(booster_pack); i++) {
-    ShopItem content = {0};
-
-    switch (booster_pack->type) {
-      case BOOSTER_PACK_STANDARD:
-        content = (ShopItem){.type = SHOP_ITEM_CARD, .card = random_card()};
-        break;
-      case BOOSTER_PACK_BUFFOON:
-        content = (ShopItem){.type = SHOP_ITEM_JOKER, .joker = random_available_joker()};
-        break;
-      case BOOSTER_PACK_CELESTIAL:
-        content.type = SHOP_ITEM_PLANET;
-        if (state.game.vouchers & VOUCHER_TELESCOPE && i == 0) {
-          PokerHand most_played = get_most_played_poker_hand();
-          content.planet = ffs(most_played) - 1;
-        } else {
-          content.planet = random_filtered_range_pick(0, 11, filter_available_planet_booster_pack);
-        }
-        break;
-      case BOOSTER_PACK_ARCANA:
-        content = (ShopItem){.type = SHOP_ITEM_TAROT,
-                             .tarot = random_filtered_range_pick(0, 21, filter_available_tarot_booster_pack)};
-
-        if (state.game.vouchers & VOUCHER_OMEN_GLOBE && random_percent(0.2))
-          content = (ShopItem){.type = SHOP_ITEM_SPECTRAL,
-                               .spectral = random_filtered_range_pick(0, 15, filter_available_spectral_booster_pack)};
-        break;
-      case BOOSTER_PACK_SPECTRAL:
-        content = (ShopItem){.type = SHOP_ITEM_SPECTRAL,
-                             .spectral = random_filtered_range_pick(0, 15, filter_available_spectral_booster_pack)};
-        break;
-    }
-
-    if ((content.type == SHOP_ITEM_SPECTRAL || content.type == SHOP_ITEM_TAROT) && random_percent(0.03))
-      content = (ShopItem){.type = SHOP_ITEM_SPECTRAL, .spectral = SPECTRAL_SOUL};
-    else if ((content.type == SHOP_ITEM_SPECTRAL || content.type == SHOP_ITEM_PLANET) && random_percent(0.03))
-      content = (ShopItem){.type = SHOP_ITEM_SPECTRAL, .spectral = SPECTRAL_BLACK_HOLE};
+    ShopItem content = create_picked_item(
+        pick_booster_pack_item(&context, booster_pack->type, i, &state.game.booster_pack.offered));
 
     cvector_push_back(state.game.booster_pack.content, content);
+    offer_item(&state.game.booster_pack.offered, &content);
   }
+
+  set_random_subsystem(previous_subsystem);
 }
 
 void close_booster_pack() {
   cvector_clear(state.game.hand.cards);
-  cvector_copy(state.game.full_deck, state.game.deck);
+  reset_deck();
 
   change_stage(state.prev_stage);
   if (state.stage == STAGE_SELECT_BLIND) trigger_immediate_tags();
@@ -1447,6 +1530,7 @@ void select_booster_pack_item() {
 
   state.game.booster_pack.uses--;
   cvector_erase(state.game.booster_pack.content, state.navigation.hovered);
+  update_offered_items(&state.game.booster_pack.offered, state.game.booster_pack.content);
   set_nav_hovered(state.navigation.hovered);
 
   if (state.game.booster_pack.uses == 0) close_booster_pack();
@@ -1454,58 +1538,13 @@ void select_booster_pack_item() {
 
 void skip_booster_pack() { close_booster_pack(); }
 
-static bool filter_available_tarot_shop(uint8_t tarot) {
-  FILTER_AVAILABLE_ITEMS(state.game.shop.items, SHOP_ITEM_TAROT, tarot);
-}
-static bool filter_available_planet_shop(uint8_t planet) {
-  if (is_planet_card_locked(planet)) return false;
-  FILTER_AVAILABLE_ITEMS(state.game.shop.items, SHOP_ITEM_PLANET, planet);
-}
-static bool filter_available_spectral_shop(uint8_t spectral) {
-  FILTER_AVAILABLE_ITEMS(state.game.shop.items, SHOP_ITEM_SPECTRAL, spectral);
-}
-
 void fill_shop_items() {
-  // Card, Tarot, Planet, Joker, Spectral
-  uint16_t shop_item_weights[5] = {0, 40, 40, 200, 0};
-
-  if (state.game.vouchers & VOUCHER_MAGIC_TRICK) shop_item_weights[0] = 40;
-
-  if (state.game.vouchers & VOUCHER_TAROT_TYCOON)
-    shop_item_weights[1] = 320;
-  else if (state.game.vouchers & VOUCHER_TAROT_MERCHANT)
-    shop_item_weights[1] = 96;
-
-  if (state.game.vouchers & VOUCHER_PLANET_TYCOON)
-    shop_item_weights[2] = 320;
-  else if (state.game.vouchers & VOUCHER_PLANET_MERCHANT)
-    shop_item_weights[2] = 96;
-
-  if (state.game.deck_type == DECK_GHOST) shop_item_weights[4] = 20;
-
+  RollContext context = get_roll_context();
   while (cvector_size(state.game.shop.items) < state.game.shop.size) {
-    ShopItemType type = random_weighted(shop_item_weights, 5);
-    ShopItem item = {.type = type};
-
-    switch (type) {
-      case SHOP_ITEM_CARD:
-        item.card = random_shop_card();
-        break;
-      case SHOP_ITEM_TAROT:
-        item.tarot = random_filtered_range_pick(0, 21, filter_available_tarot_shop);
-        break;
-      case SHOP_ITEM_PLANET:
-        item.planet = random_filtered_range_pick(0, 11, filter_available_planet_shop);
-        break;
-      case SHOP_ITEM_JOKER:
-        item.joker = random_available_joker();
-        break;
-      case SHOP_ITEM_SPECTRAL:
-        item.spectral = random_filtered_range_pick(0, 15, filter_available_spectral_shop);
-        break;
-    }
+    ShopItem item = create_picked_item(pick_shop_item(&context, &state.game.shop.offered));
 
     cvector_push_back(state.game.shop.items, item);
+    offer_item(&state.game.shop.offered, &item);
   }
 }
 
@@ -1526,20 +1565,170 @@ void reroll_shop_items() {
   state.game.money -= price;
 
   cvector_clear(state.game.shop.items);
+  state.game.shop.offered = (OfferedItems){0};
+
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_SHOP);
   fill_shop_items();
+  set_random_subsystem(previous_subsystem);
+}
+
+static uint32_t get_shop_vouchers() {
+  uint32_t vouchers = 0;
+  cvector_for_each(state.game.shop.vouchers, Voucher, voucher) vouchers |= *voucher;
+
+  return vouchers;
+}
+
+void reset_shop_arena() {
+  state.game.shop.items = NULL;
+  state.game.shop.booster_packs = NULL;
+  state.game.booster_pack.content = NULL;
+  state.game.shop.offered = (OfferedItems){0};
+  state.game.booster_pack.offered = (OfferedItems){0};
+  arena_reset(&state.game.shop_arena);
+
+  Arena *previous_arena = set_vector_arena(&state.game.shop_arena);
+  cvector_reserve(state.game.shop.items, state.game.shop.size);
+  cvector_reserve(state.game.shop.booster_packs, 2);
+  cvector_reserve(state.game.booster_pack.content, 5);
+  set_vector_arena(previous_arena);
 }
 
-bool filter_available_vouchers(uint8_t i) {
-  if (state.game.vouchers & (1 << i)) return false;
-  cvector_for_each(state.game.shop.vouchers, Voucher, voucher) if (*voucher == 1 << i) return false;
-  if (i < 16 || state.game.vouchers & (1 << (i - 16))) return true;
+// Base size with both Overstock vouchers
+#define PREPARED_SHOP_MAX_ITEMS (4)
+
+// Positions of streams which Shop rolls draw from
+typedef struct {
+  uint64_t shop;
+  uint64_t edition;
+} ShopStreamPositions;
+
+// Next Shop rolled ahead of time, restock_shop uses it only when it would roll exactly the same items, so the run
+// doesn't depend on whether it was prepared or not
+typedef struct {
+  // Started preparation follows the run until it changes, rolls of the Shop are then made one per call
+  bool is_started;
+  bool is_ready;
+  uint32_t seed;
+  uint8_t round;
+  RollContext context;
+  uint32_t owned_jokers[JOKER_ID_WORDS];
+
+  ShopStreamPositions start;
+  // Where the next roll continues from
+  ShopStreamPositions next;
+  OfferedItems offered;
+
+  uint8_t item_count;
+  uint8_t rolled_items;
+  ShopItem items[PREPARED_SHOP_MAX_ITEMS];
+  uint8_t booster_pack_count;
+  uint8_t rolled_booster_packs;
+  BoosterPackItem booster_packs[2];
+
+  // Voucher is rolled after booster packs only in the first Shop of ante
+  ShopStreamPositions voucher_start;
+  uint32_t voucher_exclusions;
+  Voucher voucher;
+  ShopStreamPositions end;
+} PreparedShop;
+
+static PreparedShop prepared_shop;
 
-  return false;
+static ShopStreamPositions get_shop_stream_positions() {
+  return (ShopStreamPositions){.shop = get_random_position(RANDOM_SUBSYSTEM_SHOP),
+                               .edition = get_random_position(RANDOM_SUBSYSTEM_EDITION)};
+}
+
+static void set_shop_stream_positions(ShopStreamPositions positions) {
+  set_random_position(RANDOM_SUBSYSTEM_SHOP, positions.shop);
+  set_random_position(RANDOM_SUBSYSTEM_EDITION, positions.edition);
+}
+
+static bool is_same_shop_stream_positions(ShopStreamPositions a, ShopStreamPositions b) {
+  return a.shop == b.shop && a.edition == b.edition;
+}
+
+// Remaining vouchers of the previous Shop are excluded from the new one
+static uint32_t get_next_shop_voucher_exclusions() {
+  return cvector_size(state.game.shop.vouchers) > 0 ? cvector_back(state.game.shop.vouchers) : 0;
+}
+
+static bool is_preparing_shop_for(const RollContext *context, ShopStreamPositions start, uint8_t item_count) {
+  PreparedShop *prepared = &prepared_shop;
+  return prepared->is_started && prepared->seed == get_random_seed() && prepared->round == state.game.round &&
+         prepared->item_count == item_count && is_same_shop_stream_positions(prepared->start, start) &&
+         is_same_roll_context(&prepared->context, context);
+}
+
+static bool is_prepared_shop_for(const RollContext *context, ShopStreamPositions start, uint8_t item_count) {
+  return prepared_shop.is_ready && is_preparing_shop_for(context, start, item_count);
+}
+
+void prepare_next_shop() {
+  if (state.stage != STAGE_GAME && state.stage != STAGE_CASH_OUT) return;
+  if (state.game.shop.size > PREPARED_SHOP_MAX_ITEMS) return;
+
+  // Jokers from these tags are rolled before the Shop, so their draws would shift it
+  cvector_for_each(state.game.tags, Tag, tag) if (*tag == TAG_UNCOMMON || *tag == TAG_RARE) return;
+
+  // Mirrors what cash_out changes before restock_shop is called
+  RollContext context = get_roll_context();
+  if (state.game.current_blind->type > BLIND_BIG) {
+    context.ante++;
+    context.defeated_boss_blinds |= 1 << state.game.current_blind->type;
+  }
+
+  ShopStreamPositions start = {
+      .shop = get_random_advanced_position(RANDOM_SUBSYSTEM_SHOP, context.ante),
+      .edition = get_random_advanced_position(RANDOM_SUBSYSTEM_EDITION, context.ante),
+  };
+
+  PreparedShop *prepared = &prepared_shop;
+  if (!is_preparing_shop_for(&context, start, state.game.shop.size) ||
+      prepared->voucher_exclusions != get_next_shop_voucher_exclusions()) {
+    *prepared = (PreparedShop){.is_started = true,
+                               .seed = get_random_seed(),
+                               .round = state.game.round,
+                               .context = context,
+                               .start = start,
+                               .next = start,
+                               .item_count = state.game.shop.size,
+                               .booster_pack_count = state.game.round == 1 ? 1 : 2,
+                               .voucher_exclusions = get_next_shop_voucher_exclusions()};
+    memcpy(prepared->owned_jokers, context.owned_jokers, sizeof(prepared->owned_jokers));
+    prepared->context.owned_jokers = prepared->owned_jokers;
+  }
+
+  if (prepared->is_ready) return;
+
+  ShopStreamPositions previous_positions = get_shop_stream_positions();
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_SHOP);
+  set_shop_stream_positions(prepared->next);
+
+  // Same rolls in the same order as restock_shop, but only one of them per call
+  if (prepared->rolled_items < prepared->item_count) {
+    ShopItem *item = &prepared->items[prepared->rolled_items++];
+    *item = create_picked_item(pick_shop_item(&prepared->context, &prepared->offered));
+    offer_item(&prepared->offered, item);
+  } else if (prepared->rolled_booster_packs < prepared->booster_pack_count) {
+    prepared->booster_packs[prepared->rolled_booster_packs++] = pick_booster_pack();
+    if (prepared->rolled_booster_packs == prepared->booster_pack_count)
+      prepared->voucher_start = get_shop_stream_positions();
+  } else {
+    prepared->voucher = pick_voucher(&prepared->context, prepared->voucher_exclusions);
+    prepared->end = get_shop_stream_positions();
+    prepared->is_ready = true;
+  }
+
+  prepared->next = get_shop_stream_positions();
+  set_shop_stream_positions(previous_positions);
+  set_random_subsystem(previous_subsystem);
 }
 
 void restock_shop() {
-  cvector_clear(state.game.shop.items);
-  cvector_clear(state.game.shop.booster_packs);
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_SHOP);
+  reset_shop_arena();
   while (cvector_size(state.game.shop.vouchers) > 1) cvector_erase(state.game.shop.vouchers, 0);
 
   uint8_t is_ante_first_shop = state.game.current_blind->type == BLIND_SMALL ||
@@ -1552,14 +1741,29 @@ void restock_shop() {
     if (tag != TAG_UNCOMMON && tag != TAG_RARE) continue;
 
     // TODO Fix adding duplicates and wrong rarity jokers when rng utilities will be added
-    ShopItem joker = {.type = SHOP_ITEM_JOKER, .is_free = true, .joker = JOKERS[random_max_value(JOKER_COUNT - 1)]};
+    ShopItem joker = {.type = SHOP_ITEM_JOKER,
+                      .is_free = true,
+                      .joker = create_joker(random_max_value(JOKER_COUNT - 1) + 1, EDITION_BASE)};
     cvector_push_back(state.game.shop.items, joker);
 
     cvector_erase(state.game.tags, i);
     i--;
   }
 
-  fill_shop_items();
+  RollContext context = get_roll_context();
+  uint8_t item_count = state.game.shop.size - cvector_size(state.game.shop.items);
+  PreparedShop *prepared =
+      is_prepared_shop_for(&context, get_shop_stream_positions(), item_count) ? &prepared_shop : NULL;
+  prepared_shop.is_ready = false;
+
+  if (prepared != NULL) {
+    for (uint8_t i = 0; i < prepared->item_count; i++) {
+      cvector_push_back(state.game.shop.items, prepared->items[i]);
+      offer_item(&state.game.shop.offered, &prepared->items[i]);
+    }
+  } else {
+    fill_shop_items();
+  }
 
   // First visit to the Shop in a run guarantees one normal Buffoon Pack
   if (state.game.round == 1) {
@@ -1567,20 +1771,19 @@ void restock_shop() {
     cvector_push_back(state.game.shop.booster_packs, booster_pack);
   }
 
-  // Standard, Arcana, Celestial, Buffoon, Spectral
-  // Normal, Jumbo, Mega
-  // Standard Normal, Standard Jumbo, Standard Mega, Arcana Normal,...
-  uint16_t booster_pack_weights[5 * 3] = {400, 200, 50, 400, 200, 50, 400, 200, 50, 120, 60, 15, 60, 30, 7};
-  for (uint8_t i = 0; i < (state.game.round == 1 ? 1 : 2); i++) {
-    uint8_t random_value = random_weighted(booster_pack_weights, 15);
-    BoosterPackItem booster_pack = {.type = random_value / 3, .size = random_value % 3};
-    cvector_push_back(state.game.shop.booster_packs, booster_pack);
+  if (prepared != NULL) {
+    for (uint8_t i = 0; i < prepared->booster_pack_count; i++)
+      cvector_push_back(state.game.shop.booster_packs, prepared->booster_packs[i]);
+    set_shop_stream_positions(prepared->voucher_start);
+  } else {
+    for (uint8_t i = 0; i < (state.game.round == 1 ? 1 : 2); i++)
+      cvector_push_back(state.game.shop.booster_packs, pick_booster_pack());
   }
 
   for (int8_t i = 0; i < cvector_size(state.game.tags); i++) {
     bool has_used_tag = false;
     if (state.game.tags[i] == TAG_VOUCHER) {
-      cvector_insert(state.game.shop.vouchers, 0, 1 << random_filtered_range_pick(0, 31, filter_available_vouchers));
+      cvector_insert(state.game.shop.vouchers, 0, pick_voucher(&context, get_shop_vouchers()));
       has_used_tag = true;
     } else if (state.game.tags[i] == TAG_COUPON) {
       cvector_for_each(state.game.shop.items, ShopItem, item) item->is_free = true;
@@ -1618,8 +1821,18 @@ void restock_shop() {
     }
   }
 
-  if (is_ante_first_shop || state.game.round == 1)
-    cvector_back(state.game.shop.vouchers) = 1 << random_filtered_range_pick(0, 31, filter_available_vouchers);
+  if (is_ante_first_shop || state.game.round == 1) {
+    // Vouchers from tags move the stream, then prepared voucher is not the one that would be rolled
+    if (prepared != NULL && prepared->voucher_exclusions == get_shop_vouchers() &&
+        is_same_shop_stream_positions(prepared->voucher_start, get_shop_stream_positions())) {
+      cvector_back(state.game.shop.vouchers) = prepared->voucher;
+      set_shop_stream_positions(prepared->end);
+    } else {
+      cvector_back(state.game.shop.vouchers) = pick_voucher(&context, get_shop_vouchers());
+    }
+  }
+
+  set_random_subsystem(previous_subsystem);
 }
 
 static void erase_first_tag_occurance(Tag tag) {
@@ -1635,8 +1848,10 @@ void exit_shop() {
   erase_first_tag_occurance(TAG_D6);
 
   state.game.shop.reroll_count = 0;
+  reset_shop_arena();
 
   change_stage(STAGE_SELECT_BLIND);
+  save_game();
 }
 
 void select_blind() {
@@ -1677,30 +1892,15 @@ void skip_blind() {
   set_nav_hovered(0);
 }
 
-uint8_t get_tag_min_ante(Tag tag) {
-  switch (tag) {
-    case TAG_NEGATIVE:
-    case TAG_STANDARD:
-    case TAG_METEOR:
-    case TAG_BUFFOON:
-    case TAG_HANDY:
-    case TAG_GARBAGE:
-    case TAG_ETHEREAL:
-    case TAG_TOPUP:
-    case TAG_ORBITAL:
-      return 2;
-
-    default:
-      return 1;
-  }
-}
+Tag roll_tag() {
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_TAG);
+  RollContext context = get_roll_context();
+  Tag tag = pick_tag(&context);
+  set_random_subsystem(previous_subsystem);
 
-static bool filter_available_tags(uint8_t i) {
-  return (state.game.ante <= 0 ? 1 : state.game.ante) >= get_tag_min_ante(i);
+  return tag;
 }
 
-Tag roll_tag() { return random_filtered_range_pick(0, 23, filter_available_tags); }
-
 void trigger_immediate_tags() {
   for (int8_t i = 0; i < cvector_size(state.game.tags); i++) {
     uint8_t should_stop = 0;
@@ -1778,69 +1978,11 @@ PokerHand get_most_played_poker_hand() {
   return max_hand;
 }
 
-uint8_t get_blind_min_ante(BlindType blind) {
-  switch (blind) {
-    case BLIND_SMALL:
-    case BLIND_BIG:
-    case BLIND_HOOK:
-    case BLIND_CLUB:
-    case BLIND_PSYCHIC:
-    case BLIND_GOAD:
-    case BLIND_WINDOW:
-    case BLIND_MANACLE:
-    case BLIND_PILLAR:
-    case BLIND_HEAD:
-      return 1;
-
-    case BLIND_HOUSE:
-    case BLIND_WALL:
-    case BLIND_WHEEL:
-    case BLIND_ARM:
-    case BLIND_FISH:
-    case BLIND_WATER:
-    case BLIND_MOUTH:
-    case BLIND_NEEDLE:
-    case BLIND_FLINT:
-    case BLIND_MARK:
-      return 2;
-
-    case BLIND_EYE:
-    case BLIND_TOOTH:
-      return 3;
-
-    case BLIND_PLANT:
-      return 4;
-
-    case BLIND_SERPENT:
-      return 5;
-
-    case BLIND_OX:
-      return 6;
-
-    case BLIND_AMBER_ACORN:
-    case BLIND_VERDANT_LEAF:
-    case BLIND_VIOLET_VESSEL:
-    case BLIND_CRIMSON_HEART:
-    case BLIND_CERULEAN_BELL:
-      return 8;
-  }
-}
-
-static bool filter_defeated_boss_blinds(uint8_t i) { return !(state.game.defeated_boss_blinds & 1 << i); }
-static bool filter_available_boss_blinds(uint8_t i) {
-  return (state.game.ante <= 0 ? 1 : state.game.ante) >= get_blind_min_ante(i) && filter_defeated_boss_blinds(i);
-}
-
 void roll_boss_blind() {
-  uint8_t available_boss_blinds = 0;
-
-  if (state.game.ante > 0 && state.game.ante % 8 == 0) {
-    state.game.blinds[2].type =
-        random_filtered_range_pick(BLIND_AMBER_ACORN, BLIND_CERULEAN_BELL, filter_defeated_boss_blinds);
-    return;
-  }
-
-  state.game.blinds[2].type = random_filtered_range_pick(BLIND_HOOK, BLIND_MARK, filter_available_boss_blinds);
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_BOSS);
+  RollContext context = get_roll_context();
+  state.game.blinds[2].type = pick_boss_blind(&context);
+  set_random_subsystem(previous_subsystem);
 }
 
 void trigger_reroll_boss_voucher() {
@@ -1891,15 +2033,19 @@ void enable_boss_blind() {
       state.game.hands.remaining = 1;
       break;
 
-    case BLIND_AMBER_ACORN:
+    case BLIND_AMBER_ACORN: {
+      RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_SHUFFLE);
       for (uint8_t i = cvector_size(state.game.jokers.cards) - 1; i > 0; i--) {
-        uint8_t j = rand() % (i + 1);
+        uint8_t j = random_max_value(i);
         Joker temp = state.game.jokers.cards[i];
         state.game.jokers.cards[i] = state.game.jokers.cards[j];
         state.game.jokers.cards[j] = temp;
       }
+      set_random_subsystem(previous_subsystem);
+
       cvector_for_each(state.game.jokers.cards, Joker, joker) joker->status |= CARD_STATUS_FACE_DOWN;
       break;
+    }
     case BLIND_VERDANT_LEAF:
       DEBUFF_CARDS_IF(1);
       break;
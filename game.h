@@ -1,13 +1,19 @@
 #ifndef GAME_H
 #define GAME_H
 
-#include <cvector.h>
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "arena.h"
 #include "content/joker.h"
 #include "content/spectral.h"
 #include "content/tarot.h"
+#include "score.h"
+#include "vector.h"
+
+// Backing memory of vectors that live through the whole run and of the ones rebuilt on every Shop visit
+#define RUN_ARENA_CAPACITY (32768)
+#define SHOP_ARENA_CAPACITY (4096)
 
 typedef enum {
   DECK_RED,
@@ -136,7 +142,7 @@ typedef struct {
 
 typedef struct {
   double mult;
-  uint32_t chips;
+  double chips;
 } ScorePair;
 
 typedef enum {
@@ -183,6 +189,9 @@ typedef struct {
 } Blind;
 
 struct Card {
+  // Unique within a run, links cards in hand and deck with their full deck entry
+  uint16_t id;
+
   Suit suit;
   Rank rank;
 
@@ -201,6 +210,36 @@ struct Card {
 };
 typedef struct Card Card;
 
+// Cards are counted by their printed suit and rank, wild and stone cards included
+typedef struct {
+  uint16_t total;
+  uint16_t ranks[13];
+  uint16_t suits[4];
+  uint16_t enhancements[9];
+  uint16_t cards[4][13];
+
+  // Stone cards have no rank or suit, wild cards have every suit
+  uint16_t playable_ranks[13];
+  uint16_t natural_suits[4];
+} DeckCounts;
+
+// Card as it counts towards poker hands that can be formed from a set of cards
+typedef struct {
+  // 0 for stone cards, they have no rank
+  uint16_t rank_bit;
+  // 1 in 8-bit lane of every suit the card has, wild cards have all four and stone cards none
+  uint32_t suit_lanes;
+} HistogramCard;
+
+// Poker hands that can be formed from cards added one by one, evaluated without any loop over ranks.
+// It is small enough to be copied for every sample of a rollout.
+typedef struct {
+  // Rank bit is set in plane i once there are more than i cards of that rank, more than 5 don't form any better hand
+  uint16_t rank_planes[5];
+  // Number of cards of every suit in 8-bit lanes
+  uint32_t suit_counts;
+} HandHistogram;
+
 typedef struct {
   // Max number of cards in structure that can be obtained naturally
   // (some bosses/jokers will be able to overflow this value)
@@ -231,9 +270,14 @@ typedef struct {
   cvector_vector_type(Consumable) items;
 } Consumables;
 
+// Joker ids fit in uint8_t, one bit for each of them
+#define JOKER_ID_WORDS (256 / 32)
+
 typedef struct {
   uint8_t size;
   cvector_vector_type(Joker) cards;
+  // Ids of owned jokers, kept in sync by add_joker_to_player and remove_joker_from_player
+  uint32_t owned[JOKER_ID_WORDS];
 } JokerHand;
 
 typedef struct {
@@ -311,10 +355,18 @@ typedef struct {
   bool is_free;
 } BoosterPackItem;
 
+// One bit for each consumable which is currently offered, so rolls can skip them without scanning items
+typedef struct {
+  uint32_t tarots;
+  uint32_t planets;
+  uint32_t spectrals;
+} OfferedItems;
+
 typedef struct {
   uint8_t uses;
   BoosterPackItem item;
   cvector_vector_type(ShopItem) content;
+  OfferedItems offered;
 } BoosterPack;
 
 typedef struct {
@@ -323,6 +375,7 @@ typedef struct {
   cvector_vector_type(Voucher) vouchers;
   cvector_vector_type(ShopItem) items;
   cvector_vector_type(BoosterPackItem) booster_packs;
+  OfferedItems offered;
 } Shop;
 
 typedef enum { SORTING_BY_RANK, SORTING_BY_SUIT } SortingMode;
@@ -339,11 +392,19 @@ typedef struct {
 } Stats;
 
 typedef struct {
+  Arena run_arena;
+  Arena shop_arena;
+
   Deck deck_type;
   Stake stake;
+  // Every roll of the run follows from it
+  uint32_t seed;
 
   cvector_vector_type(Card) full_deck;
+  cvector_vector_type(uint16_t) full_deck_index;
   cvector_vector_type(Card) deck;
+  DeckCounts full_deck_counts;
+  DeckCounts deck_counts;
 
   Hand hand;
   SelectedHand selected_hand;
@@ -352,7 +413,7 @@ typedef struct {
   JokerHand jokers;
   Consumables consumables;
 
-  double score;
+  BigScore score;
   uint8_t ante;
   uint8_t round;
 
@@ -379,7 +440,8 @@ typedef struct {
   Stats stats;
 } Game;
 
-void game_init(Deck deck, Stake stake);
+// Same seed always starts the same run, see get_new_run_seed for seed of a new run
+void game_init(Deck deck, Stake stake, uint32_t seed);
 void game_destroy();
 void generate_deck();
 void apply_deck_settings();
@@ -405,8 +467,21 @@ uint8_t is_suit(Card *card, Suit suit);
 uint8_t is_poker_hand_unknown();
 bool is_planet_card_locked(Planet planet);
 bool filter_locked_planet_cards(uint8_t planet);
+uint32_t get_unlocked_planets();
 
+// Poker hands of selected cards, classified by the same histogram as draw odds
 uint16_t evaluate_hand();
+HistogramCard to_histogram_card(const Card *card);
+void add_histogram_card(HandHistogram *histogram, HistogramCard card);
+// Straight Flush, Flush House and Flush Five need ranks of the flush suit alone, so they are left out. Histogram of
+// cards of any suit returned by get_flush_suit_lanes gives them with get_suited_histogram_hands.
+uint16_t get_histogram_hands(const HandHistogram *histogram);
+uint32_t get_flush_suit_lanes(const HandHistogram *histogram);
+// Evaluates samples which share base cards and differ in drawn ones, e.g. draws of a rollout.
+// Drawn holds draw count indices into cards for every sample, suited hands are left out as above.
+void evaluate_histogram_batch(const HandHistogram *base, const HistogramCard *cards, const uint16_t *drawn,
+                              uint8_t draw_count, uint8_t sample_count, uint16_t *results);
+uint16_t get_suited_histogram_hands(const HandHistogram *suited);
 uint8_t does_poker_hand_contain(uint16_t hand_union, PokerHand expected);
 PokerHand get_poker_hand(uint16_t hand_union);
 void update_scoring_hand();
@@ -417,8 +492,8 @@ PokerHandStats *get_poker_hand_stats(uint16_t hand_union);
 ScorePair get_poker_hand_base_score(uint16_t hand_union);
 ScorePair get_planet_card_base_score(uint16_t hand_union);
 ScorePair get_poker_hand_total_score(uint16_t hand_union);
-double get_ante_base_score(uint8_t ante);
-double get_required_score(uint8_t ante, BlindType blind_type);
+BigScore get_ante_base_score(uint8_t ante);
+BigScore get_required_score(uint8_t ante, BlindType blind_type);
 
 uint8_t get_blind_money(BlindType blind_type);
 uint8_t get_hands_money();
@@ -430,21 +505,31 @@ void cash_out();
 
 uint8_t use_consumable(Consumable *consumable);
 uint8_t add_item_to_player(ShopItem *item);
+void add_joker_to_player(Joker *joker);
+void remove_joker_from_player(uint8_t index);
+void clear_player_jokers();
+bool is_joker_owned(JokerId id);
+Joker random_available_joker();
+Joker random_available_joker_by_rarity(Rarity rarity);
 uint8_t get_shop_item_price(ShopItem *item);
 uint8_t get_voucher_price(Voucher voucher);
 void add_voucher_to_player(Voucher voucher);
 uint8_t get_booster_pack_price(BoosterPackItem *booster_pack);
-uint8_t get_booster_pack_items_count(BoosterPackItem *booster_pack);
 uint8_t get_shop_item_sell_price(ShopItem *item);
 void buy_item(bool should_use);
 void sell_shop_item();
 void open_booster_pack(BoosterPackItem *booster_pack);
 void select_booster_pack_item();
 void skip_booster_pack();
+void update_offered_items(OfferedItems *offered, cvector_vector_type(ShopItem) items);
 void fill_shop_items();
 uint8_t get_reroll_price();
 void reroll_shop_items();
+void reset_shop_arena();
 void restock_shop();
+// Rolls the next Shop ahead of time while blind is played, one item, booster pack or voucher per call.
+// Called every frame, so no frame has to roll the whole Shop.
+void prepare_next_shop();
 void exit_shop();
 
 void select_blind();
@@ -454,7 +539,6 @@ void trigger_immediate_tags();
 
 PokerHand get_most_played_poker_hand();
 
-uint8_t get_blind_min_ante(BlindType blind);
 void roll_boss_blind();
 void trigger_reroll_boss_voucher();
 void enable_boss_blind();
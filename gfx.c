@@ -1,20 +1,28 @@
 #include "gfx.h"
 
-#include <cvector.h>
 #include <math.h>
 #include <pspgu.h>
+#include <pspkernel.h>
 #include <stdarg.h>
 #include <stdio.h>
 
+#include "card_cache.h"
+#include "compositor.h"
 #include "content/joker.h"
+#include "debug.h"
 #include "game.h"
+#include "jobs.h"
+#include "odds.h"
 #include "renderer.h"
 #include "state.h"
 #include "system.h"
 #include "text.h"
 #include "utils.h"
+#include "vector.h"
 
 void update_render_commands() {
+  // Strings and custom elements of previous layout are no longer referenced
+  frame_arena_reset();
   Clay_BeginLayout();
 
   CLAY({.id = CLAY_ID("Container"), .layout = {.sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)}}}) {
@@ -76,6 +84,10 @@ void update_render_commands() {
   }
 
   state.render_commands = Clay_EndLayout();
+  compositor_track_layout(&state.render_commands);
+  frame_arena_update_stats();
+  update_layout_stats();
+  trace_event(TRACE_EVENT_LAYOUT, state.render_commands.length, frame_arena_get_used());
 }
 
 const Clay_String main_menu_buttons[] = {CLAY_STRING("Play"), CLAY_STRING("Credits"), CLAY_STRING("Quit")};
@@ -138,10 +150,10 @@ void render_select_deck() {
           Deck deck = get_current_section() == NAVIGATION_SELECT_DECK ? state.navigation.hovered
                                                                       : state.prev_navigation.hovered;
           Clay_String deck_name;
-          append_clay_string(&deck_name, "%s", get_deck_name(deck));
+          deck_name = static_clay_string(get_deck_name(deck));
 
           Clay_String deck_description;
-          append_clay_string(&deck_description, "%s", get_deck_description(deck));
+          deck_description = static_clay_string(get_deck_description(deck));
 
           CLAY_TEXT(deck_name, WHITE_TEXT_CONFIG);
           CLAY_TEXT(deck_description, WHITE_TEXT_CONFIG);
@@ -177,20 +189,43 @@ void render_credits() {
   }
 }
 
-void render_atlas_sprite(Texture *atlas, Vector2 *sprite_index, Rect *dst) {
-  float angle = 3.0f * sinf(state.time * 0.75f - dst->x / SCREEN_WIDTH * M_PI * 3);
-  Rect src = {.x = sprite_index->x * CARD_WIDTH, .y = sprite_index->y * CARD_HEIGHT, .w = CARD_WIDTH, .h = CARD_HEIGHT};
+static float get_sprite_angle(Rect *dst) {
+  return 3.0f * sinf(state.animation_time * 0.75f - dst->x / SCREEN_WIDTH * M_PI * 3);
+}
+
+void render_sprite_layers(SpriteLayer *layers, uint8_t count, Rect *dst, float angle) {
+  for (uint8_t i = 0; i < count; i++) {
+    Rect src = {.x = layers[i].sprite.x * CARD_WIDTH,
+                .y = layers[i].sprite.y * CARD_HEIGHT,
+                .w = CARD_WIDTH,
+                .h = CARD_HEIGHT};
+    draw_texture(layers[i].atlas, &src, dst, 0xFFFFFFFF, angle);
+  }
+}
+
+// Items made of multiple layers are drawn as one sprite from card cache
+static void render_cached_sprite_layers(uint32_t key, SpriteLayer *layers, uint8_t count, Rect *dst) {
+  float angle = get_sprite_angle(dst);
+
+  Rect *src = count > 1 ? get_cached_card(key, layers, count) : NULL;
+  if (src == NULL) {
+    render_sprite_layers(layers, count, dst, angle);
+    return;
+  }
+
+  draw_texture(get_card_cache_texture(), src, dst, 0xFFFFFFFF, angle);
+}
 
-  draw_texture(atlas, &src, dst, 0xFFFFFFFF, angle);
+void render_atlas_sprite(Texture *atlas, Vector2 *sprite_index, Rect *dst) {
+  render_sprite_layers(&(SpriteLayer){atlas, *sprite_index}, 1, dst, get_sprite_angle(dst));
 }
 
 void render_card_atlas_sprite(Vector2 *sprite_index, Rect *dst) {
   render_atlas_sprite(state.cards_atlas, sprite_index, dst);
 }
 
-void render_edition(Edition edition, Rect *dst) {
-  Vector2 src = {.x = 5 + edition - 1, .y = 3};
-  if (edition != EDITION_BASE) render_card_atlas_sprite(&src, dst);
+static void add_edition_layer(SpriteLayer *layers, uint8_t *count, Edition edition) {
+  if (edition != EDITION_BASE) layers[(*count)++] = (SpriteLayer){state.cards_atlas, {.x = 5 + edition - 1, .y = 3}};
 }
 
 void render_card(Card *card, Rect *dst) {
@@ -203,21 +238,28 @@ void render_card(Card *card, Rect *dst) {
     return;
   }
 
+  SpriteLayer layers[CARD_CACHE_MAX_LAYERS];
+  uint8_t count = 0;
+
   Vector2 background = {.x = 9, .y = 7};
   if (card->enhancement != ENHANCEMENT_NONE) {
     uint8_t enhancement_offset = card->enhancement - 1;
     background.x = 5 + enhancement_offset % 4;
     background.y = 5 + 2 * floorf(enhancement_offset / 4.0f);
   }
-  render_card_atlas_sprite(&background, dst);
+  layers[count++] = (SpriteLayer){state.cards_atlas, background};
 
   Vector2 face = {.x = card->rank % 10, .y = 2 * card->suit + floorf(card->rank / 10.0f)};
-  if (card->enhancement != ENHANCEMENT_STONE) render_card_atlas_sprite(&face, dst);
+  if (card->enhancement != ENHANCEMENT_STONE) layers[count++] = (SpriteLayer){state.cards_atlas, face};
 
-  render_edition(card->edition, dst);
+  add_edition_layer(layers, &count, card->edition);
 
   Vector2 seal = {.x = 5 + card->seal - 1, .y = 1};
-  if (card->seal != SEAL_NONE) render_card_atlas_sprite(&seal, dst);
+  if (card->seal != SEAL_NONE) layers[count++] = (SpriteLayer){state.cards_atlas, seal};
+
+  uint32_t key = CARD_CACHE_KEY_CARD | card->suit | card->rank << 4 | card->enhancement << 8 | card->edition << 16 |
+                 card->seal << 20;
+  render_cached_sprite_layers(key, layers, count, dst);
 }
 
 void render_joker(Joker *joker, Rect *dst) {
@@ -235,8 +277,11 @@ void render_joker(Joker *joker, Rect *dst) {
   Vector2 sprite = {.x = index % 10, .y = floorf(index / 10.0f)};
   Texture *atlas = joker->id <= 80 ? state.jokers_atlas1 : state.jokers_atlas2;
 
-  render_atlas_sprite(atlas, &sprite, dst);
-  render_edition(joker->edition, dst);
+  SpriteLayer layers[CARD_CACHE_MAX_LAYERS] = {{atlas, sprite}};
+  uint8_t count = 1;
+  add_edition_layer(layers, &count, joker->edition);
+
+  render_cached_sprite_layers(CARD_CACHE_KEY_JOKER | joker->id | joker->edition << 16, layers, count, dst);
 }
 
 void render_consumable(Consumable *consumable, Rect *dst) {
@@ -276,15 +321,20 @@ void render_tooltip(Clay_String *title, Clay_String *description, float y_offset
         }}) {
     CLAY({.backgroundColor = COLOR_CARD_BG,
           .layout = {
-              .padding = CLAY_PADDING_ALL(4),
+              .padding = CLAY_PADDING_ALL(TOOLTIP_PADDING),
               .childGap = 2,
-              .sizing = {CLAY_SIZING_GROW(0, 100), CLAY_SIZING_GROW(0)},
+              .sizing = {CLAY_SIZING_GROW(0, TOOLTIP_MAX_WIDTH), CLAY_SIZING_GROW(0)},
               .layoutDirection = CLAY_TOP_TO_BOTTOM,
           }}) {
-      CLAY_TEXT(*title, WHITE_TEXT_CONFIG);
-      CLAY_TEXT(*description, WHITE_TEXT_CONFIG);
-
-      if (other_description) CLAY_TEXT(*other_description, CLAY_TEXT_CONFIG({.textColor = COLOR_CARD_LIGHT_BG}));
+      // Line breaks are precomputed, so Clay does not have to wrap words on every layout
+      Clay_TextElementConfig *text_config =
+          CLAY_TEXT_CONFIG({.textColor = COLOR_WHITE, .wrapMode = CLAY_TEXT_WRAP_NEWLINES});
+      CLAY_TEXT(wrap_text(*title, TOOLTIP_LINE_LENGTH), text_config);
+      CLAY_TEXT(wrap_text(*description, TOOLTIP_LINE_LENGTH), text_config);
+
+      if (other_description)
+        CLAY_TEXT(wrap_text(*other_description, TOOLTIP_LINE_LENGTH),
+                  CLAY_TEXT_CONFIG({.textColor = COLOR_CARD_LIGHT_BG, .wrapMode = CLAY_TEXT_WRAP_NEWLINES}));
     }
   }
 }
@@ -350,10 +400,10 @@ void render_spread_items(NavigationSection section, Clay_String parent_id) {
           }
 
           Clay_String *other_description = NULL;
-          if (element->type == CUSTOM_ELEMENT_JOKER && element->joker.get_scaling_description) {
+          if (element->type == CUSTOM_ELEMENT_JOKER && JOKERS[element->joker.id].get_scaling_description) {
             Clay_String scaling_description;
             other_description = &scaling_description;
-            element->joker.get_scaling_description(&element->joker, other_description);
+            JOKERS[element->joker.id].get_scaling_description(&element->joker, other_description);
           }
 
           render_tooltip(&name, &description, y_offset, &attach_points, other_description);
@@ -489,11 +539,11 @@ void render_sidebar() {
           .backgroundColor = COLOR_MONEY}) {
       Clay_String stage;
       if (state.stage == STAGE_GAME)
-        append_clay_string(&stage, "%s", get_blind_name(state.game.current_blind->type));
+        stage = static_clay_string(get_blind_name(state.game.current_blind->type));
       else if (state.stage == STAGE_SELECT_BLIND)
-        append_clay_string(&stage, "Choose your next Blind");
+        stage = static_clay_string("Choose your next Blind");
       else
-        append_clay_string(&stage, "SHOP");
+        stage = static_clay_string("SHOP");
 
       CLAY_TEXT(stage, CLAY_TEXT_CONFIG({.textAlignment = CLAY_TEXT_ALIGN_CENTER, .textColor = COLOR_WHITE}));
     }
@@ -502,9 +552,12 @@ void render_sidebar() {
       CLAY(sidebar_block_config) {
         CLAY_TEXT(CLAY_STRING("Score at least:"),
                   CLAY_TEXT_CONFIG({.textColor = COLOR_WHITE, .wrapMode = CLAY_TEXT_WRAP_NONE}));
+        char required_score_text[24];
+        score_format(required_score_text, sizeof(required_score_text),
+                     get_required_score(state.game.ante, state.game.current_blind->type));
+
         Clay_String required_score;
-        append_clay_string(&required_score, "%.0lf",
-                           get_required_score(state.game.ante, state.game.current_blind->type));
+        append_clay_string(&required_score, "%s", required_score_text);
 
         CLAY_TEXT(required_score, CLAY_TEXT_CONFIG({.textColor = {255, 63, 52, 255}}));
       }
@@ -525,8 +578,11 @@ void render_sidebar() {
       CLAY({.id = CLAY_ID_LOCAL("ScoreValue"),
             .layout = {.sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
                        .childAlignment = {CLAY_ALIGN_X_CENTER, CLAY_ALIGN_Y_CENTER}}}) {
+        char score_text[24];
+        score_format(score_text, sizeof(score_text), state.game.score);
+
         Clay_String score;
-        append_clay_string(&score, "%.0lf", state.game.score);
+        append_clay_string(&score, "%s", score_text);
 
         CLAY_TEXT(score, CLAY_TEXT_CONFIG({.textColor = {255, 63, 52, 255}}));
       }
@@ -555,7 +611,7 @@ void render_sidebar() {
                          .childAlignment = {CLAY_ALIGN_X_RIGHT, CLAY_ALIGN_Y_CENTER}},
               .backgroundColor = COLOR_CHIPS}) {
           Clay_String chips;
-          append_clay_string(&chips, "%d", state.game.selected_hand.score_pair.chips);
+          append_clay_string(&chips, "%.0lf", state.game.selected_hand.score_pair.chips);
 
           CLAY_TEXT(state.game.selected_hand.count == 0 ? CLAY_STRING(" ")
                     : is_poker_hand_unknown()           ? CLAY_STRING("?")
@@ -595,6 +651,20 @@ void render_sidebar() {
       Clay_String discards;
       append_clay_string(&discards, "%d", state.game.discards.remaining);
       CLAY_TEXT(discards, WHITE_TEXT_CONFIG);
+
+      if (state.stage == STAGE_GAME && state.game.selected_hand.count > 0 && state.game.discards.remaining > 0) {
+        // Best poker hand that is reasonably likely after discarding selected cards
+        // Nothing is shown until odds are computed on job thread
+        const DrawOdds *odds = get_draw_odds();
+        for (uint8_t i = 0; odds != NULL && i < 12; i++) {
+          if (odds->probability[i] < DRAW_ODDS_HINT_THRESHOLD) continue;
+
+          Clay_String hint;
+          append_clay_string(&hint, "%s %.0f%%", get_poker_hand_name(1 << i), 100 * odds->probability[i]);
+          CLAY_TEXT(hint, CLAY_TEXT_CONFIG({.textColor = COLOR_CHIPS}));
+          break;
+        }
+      }
     }
 
     CLAY(sidebar_block_config) {
@@ -611,7 +681,10 @@ void render_sidebar() {
         CLAY_TEXT(CLAY_STRING("Ante"), WHITE_TEXT_CONFIG);
 
         Clay_String ante;
-        append_clay_string(&ante, "%d/8", state.game.ante);
+        if (state.game.ante > 8)
+          append_clay_string(&ante, "%d", state.game.ante);
+        else
+          append_clay_string(&ante, "%d/8", state.game.ante);
         CLAY_TEXT(ante, WHITE_TEXT_CONFIG);
       }
 
@@ -798,10 +871,10 @@ void render_blind_element(uint8_t blind_index) {
 
       if (is_current_blind && is_select_button_hovered && state.game.current_blind->type > BLIND_BIG) {
         Clay_String blind_name;
-        append_clay_string(&blind_name, "%s", get_blind_name(state.game.current_blind->type));
+        blind_name = static_clay_string(get_blind_name(state.game.current_blind->type));
 
         Clay_String blind_description;
-        append_clay_string(&blind_description, "%s", get_blind_description(state.game.current_blind->type));
+        blind_description = static_clay_string(get_blind_description(state.game.current_blind->type));
 
         render_tooltip(&blind_name, &blind_description, -4,
                        &(Clay_FloatingAttachPoints){.parent = CLAY_ATTACH_POINT_CENTER_TOP,
@@ -811,11 +884,14 @@ void render_blind_element(uint8_t blind_index) {
     }
 
     Clay_String blind_name;
-    append_clay_string(&blind_name, "%s", get_blind_name(blind->type));
+    blind_name = static_clay_string(get_blind_name(blind->type));
     CLAY_TEXT(blind_name, WHITE_TEXT_CONFIG);
 
+    char score_text[24];
+    score_format(score_text, sizeof(score_text), get_required_score(state.game.ante, blind->type));
+
     Clay_String score;
-    append_clay_string(&score, "Score at least:\n%.0lf", get_required_score(state.game.ante, blind->type));
+    append_clay_string(&score, "Score at least:\n%s", score_text);
     CLAY_TEXT(score, WHITE_TEXT_CONFIG);
 
     Clay_String money;
@@ -825,9 +901,9 @@ void render_blind_element(uint8_t blind_index) {
     if (blind->type > BLIND_BIG) continue;
 
     Clay_String tag_name;
-    append_clay_string(&tag_name, "%s", get_tag_name(blind->tag));
+    tag_name = static_clay_string(get_tag_name(blind->tag));
     Clay_String tag_description;
-    append_clay_string(&tag_description, "%s", get_tag_description(blind->tag));
+    tag_description = static_clay_string(get_tag_description(blind->tag));
 
     uint8_t is_skip_button_hovered = is_current_blind && is_current_section && state.navigation.hovered == 1;
     CLAY_TEXT(CLAY_STRING("or"), WHITE_TEXT_CONFIG);
@@ -862,14 +938,15 @@ void render_select_blind() {
 
 void render_game_over() { CLAY_TEXT(CLAY_STRING("You've lost:("), WHITE_TEXT_CONFIG); }
 
-const Clay_ElementDeclaration overlay_bg_config =
-    (Clay_ElementDeclaration){.floating = {.zIndex = 10, .attachTo = CLAY_ATTACH_TO_ROOT},
-                              .layout =
-                                  {
-                                      .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
-                                      .childAlignment = {CLAY_ALIGN_X_CENTER, CLAY_ALIGN_Y_CENTER},
-                                  },
-                              .backgroundColor = {0, 0, 0, 150}};
+const Clay_ElementDeclaration overlay_bg_config = {
+    .floating = {.zIndex = 10, .attachTo = CLAY_ATTACH_TO_ROOT},
+    .layout =
+        {
+            .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
+            .childAlignment = {CLAY_ALIGN_X_CENTER, CLAY_ALIGN_Y_CENTER},
+        },
+    .backgroundColor = {0, 0, 0, 150},
+};
 
 const Clay_String overlay_menu_buttons[] = {CLAY_STRING("Continue"), CLAY_STRING("Poker hands"), CLAY_STRING("Restart"),
                                             CLAY_STRING("Go to main menu")};
@@ -904,10 +981,10 @@ void render_overlay_select_stake() {
                      .childGap = 4},
           .backgroundColor = COLOR_CARD_BG_ALPHA(200)}) {
       Clay_String stake_name;
-      append_clay_string(&stake_name, "%s", get_stake_name(state.navigation.hovered));
+      stake_name = static_clay_string(get_stake_name(state.navigation.hovered));
 
       Clay_String stake_description;
-      append_clay_string(&stake_description, "%s", get_stake_description(state.navigation.hovered));
+      stake_description = static_clay_string(get_stake_description(state.navigation.hovered));
 
       CLAY_TEXT(stake_name, WHITE_TEXT_CONFIG);
       CLAY_TEXT(stake_description, WHITE_TEXT_CONFIG);
@@ -967,7 +1044,7 @@ void render_overlay_poker_hands() {
                       .padding = {.left = 2, .right = 2},
                   }}) {
               Clay_String chips;
-              append_clay_string(&chips, "%d", score.chips);
+              append_clay_string(&chips, "%.0lf", score.chips);
               CLAY_TEXT(chips, WHITE_TEXT_CONFIG);
             }
 
@@ -1048,9 +1125,9 @@ float perlin(float x, float y) {
   return lerp(x1, x2, v);
 }
 
-void init_background() {
-  state.bg = init_texture(BG_NOISE_SIZE, BG_NOISE_SIZE);
+static bool is_background_ready = false;
 
+static void generate_background(void *data) {
   for (int i = 0; i < BG_PERIOD; i++) PERLIN_PERM[i] = i;
   for (int i = BG_PERIOD - 1; i > 0; i--) {
     int j = rand() % (i + 1);
@@ -1082,9 +1159,28 @@ void init_background() {
   }
 }
 
+static void complete_background(void *data) {
+  // Generated through CPU cache, so it has to reach VRAM before GPU samples it
+  sceKernelDcacheWritebackInvalidateAll();
+  is_background_ready = true;
+  compositor_mark_all_dirty();
+}
+
+void init_background() {
+  state.bg = init_texture(BG_NOISE_SIZE, BG_NOISE_SIZE);
+
+  Job job = {.run = generate_background, .complete = complete_background};
+  if (!job_submit(JOB_PRIORITY_NORMAL, job)) {
+    generate_background(NULL);
+    complete_background(NULL);
+  }
+}
+
 void render_background() {
-  float x_offest = state.time * SCREEN_WIDTH * 0.0078125f;
-  float y_offest = state.time * SCREEN_HEIGHT * 0.0078125f;
+  if (!is_background_ready) return;
+
+  float x_offest = state.background_time * SCREEN_WIDTH * 0.0078125f;
+  float y_offest = state.background_time * SCREEN_HEIGHT * 0.0078125f;
 
   draw_texture(state.bg, &(Rect){.x = x_offest, .y = y_offest, .w = BG_TEXTURE_WIDTH, .h = BG_TEXTURE_HEIGHT},
                &(Rect){.x = 0, .y = 0, .w = SCREEN_WIDTH, .h = SCREEN_HEIGHT}, RGB(255, 255, 255), 0);
@@ -1,6 +1,7 @@
 #ifndef GFX_H
 #define GFX_H
 
+#include "card_cache.h"
 #include "game.h"
 #include "state.h"
 #include "system.h"
@@ -23,6 +24,12 @@
 #define SIDEBAR_GAP (4)
 #define SECTION_PADDING (4)
 
+#define TOOLTIP_MAX_WIDTH (100)
+#define TOOLTIP_PADDING (4)
+#define TOOLTIP_LINE_LENGTH ((TOOLTIP_MAX_WIDTH - 2 * TOOLTIP_PADDING) / CHAR_WIDTH)
+
+#define DRAW_ODDS_HINT_THRESHOLD (0.1f)
+
 #define COLOR_WHITE (Clay_Color){255, 255, 255, 255}
 #define COLOR_BLACK (Clay_Color){0, 0, 0, 255}
 #define COLOR_MULT (Clay_Color){255, 63, 52, 255}
@@ -42,6 +49,7 @@ void render_main_menu();
 void render_select_deck();
 void render_credits();
 
+void render_sprite_layers(SpriteLayer *layers, uint8_t count, Rect *dst, float angle);
 void render_card_atlas_sprite(Vector2 *sprite_index, Rect *dst);
 void render_card(Card *card, Rect *dst);
 void render_joker(Joker *joker, Rect *dst);
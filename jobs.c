@@ -0,0 +1,195 @@
+#include "jobs.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "debug.h"
+
+#ifdef __PSP__
+#include <pspkernel.h>
+#include <pspthreadman.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+// Below trace flush thread, so long jobs don't let trace ring fill up
+#define JOBS_THREAD_PRIORITY (0x38)
+#define JOBS_THREAD_STACK_SIZE (0x10000)
+
+typedef struct {
+  Job jobs[JOBS_MAX_IN_FLIGHT];
+  uint8_t head;
+  uint8_t count;
+} JobQueue;
+
+// Everything below is guarded by jobs lock
+static JobQueue queues[JOB_PRIORITY_COUNT];
+static JobQueue completed;
+// Submitted jobs whose completion hasn't been run yet, so completed queue can never overflow
+static uint8_t in_flight_count = 0;
+static bool is_stopping = false;
+
+// Changed only by main thread while worker is not running
+static bool has_worker = false;
+
+#ifdef __PSP__
+static SceUID lock_sema = -1;
+static SceUID work_sema = -1;
+static SceUID worker_thread = -1;
+
+static void jobs_lock() { sceKernelWaitSema(lock_sema, 1, NULL); }
+static bool jobs_try_lock() { return sceKernelPollSema(lock_sema, 1) >= 0; }
+static void jobs_unlock() { sceKernelSignalSema(lock_sema, 1); }
+static void signal_work() { sceKernelSignalSema(work_sema, 1); }
+static void wait_work() { sceKernelWaitSema(work_sema, 1, NULL); }
+#else
+static pthread_mutex_t lock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sem_t work_sema;
+static pthread_t worker_thread;
+
+static void jobs_lock() { pthread_mutex_lock(&lock_mutex); }
+static bool jobs_try_lock() { return pthread_mutex_trylock(&lock_mutex) == 0; }
+static void jobs_unlock() { pthread_mutex_unlock(&lock_mutex); }
+static void signal_work() { sem_post(&work_sema); }
+static void wait_work() { sem_wait(&work_sema); }
+#endif
+
+static void push_job(JobQueue *queue, Job job) {
+  queue->jobs[(queue->head + queue->count) % JOBS_MAX_IN_FLIGHT] = job;
+  queue->count++;
+}
+
+static bool pop_job(JobQueue *queue, Job *job) {
+  if (queue->count == 0) return false;
+
+  *job = queue->jobs[queue->head];
+  queue->head = (queue->head + 1) % JOBS_MAX_IN_FLIGHT;
+  queue->count--;
+  return true;
+}
+
+static void run_worker() {
+  while (true) {
+    wait_work();
+
+    Job job;
+    bool has_job = false;
+    jobs_lock();
+    for (JobPriority priority = 0; priority < JOB_PRIORITY_COUNT && !has_job; priority++)
+      has_job = pop_job(&queues[priority], &job);
+    // Worker stops only once every queued job has been run
+    bool should_stop = !has_job && is_stopping;
+    jobs_unlock();
+
+    if (should_stop) return;
+    if (!has_job) continue;
+
+    job.run(job.data);
+
+    jobs_lock();
+    push_job(&completed, job);
+    jobs_unlock();
+  }
+}
+
+#ifdef __PSP__
+static int worker_thread_entry(SceSize args, void *argp) {
+  run_worker();
+  return 0;
+}
+
+static bool start_worker() {
+  lock_sema = sceKernelCreateSema("jobs_lock_sema", 0, 1, 1, NULL);
+  work_sema = sceKernelCreateSema("jobs_work_sema", 0, 0, JOBS_MAX_IN_FLIGHT + 1, NULL);
+  worker_thread = sceKernelCreateThread("jobs_thread", worker_thread_entry, JOBS_THREAD_PRIORITY,
+                                        JOBS_THREAD_STACK_SIZE, PSP_THREAD_ATTR_USER, NULL);
+  if (lock_sema >= 0 && work_sema >= 0 && worker_thread >= 0 && sceKernelStartThread(worker_thread, 0, NULL) >= 0)
+    return true;
+
+  if (worker_thread >= 0) sceKernelDeleteThread(worker_thread);
+  if (work_sema >= 0) sceKernelDeleteSema(work_sema);
+  if (lock_sema >= 0) sceKernelDeleteSema(lock_sema);
+  return false;
+}
+
+static void stop_worker() {
+  sceKernelWaitThreadEnd(worker_thread, NULL);
+  sceKernelDeleteThread(worker_thread);
+  sceKernelDeleteSema(work_sema);
+  sceKernelDeleteSema(lock_sema);
+}
+#else
+static void *worker_thread_entry(void *argp) {
+  run_worker();
+  return NULL;
+}
+
+static bool start_worker() {
+  if (sem_init(&work_sema, 0, 0) != 0) return false;
+  if (pthread_create(&worker_thread, NULL, worker_thread_entry, NULL) == 0) return true;
+
+  sem_destroy(&work_sema);
+  return false;
+}
+
+static void stop_worker() {
+  pthread_join(worker_thread, NULL);
+  sem_destroy(&work_sema);
+}
+#endif
+
+void jobs_init() {
+  is_stopping = false;
+  has_worker = start_worker();
+  if (!has_worker) log_message(LOG_ERROR, "Failed to start job thread, jobs will run on main thread.");
+}
+
+void jobs_destroy() {
+  if (!has_worker) return;
+
+  jobs_lock();
+  is_stopping = true;
+  jobs_unlock();
+  signal_work();
+
+  // Jobs can't be cancelled, e.g. save has to be written completely
+  stop_worker();
+  has_worker = false;
+
+  Job job;
+  while (pop_job(&completed, &job))
+    if (job.complete != NULL) job.complete(job.data);
+  in_flight_count = 0;
+}
+
+bool job_submit(JobPriority priority, Job job) {
+  if (!has_worker) return false;
+
+  jobs_lock();
+  bool can_submit = in_flight_count < JOBS_MAX_IN_FLIGHT && !is_stopping;
+  if (can_submit) {
+    push_job(&queues[priority], job);
+    in_flight_count++;
+  }
+  jobs_unlock();
+
+  if (can_submit) signal_work();
+  return can_submit;
+}
+
+void jobs_complete() {
+  if (!has_worker) return;
+  // Worker holds the lock only for a moment, finished jobs are picked up next frame then
+  if (!jobs_try_lock()) return;
+
+  Job finished[JOBS_MAX_IN_FLIGHT];
+  uint8_t finished_count = 0;
+  while (pop_job(&completed, &finished[finished_count])) finished_count++;
+  in_flight_count -= finished_count;
+  jobs_unlock();
+
+  // Completions run without the lock, so they can submit new jobs
+  for (uint8_t i = 0; i < finished_count; i++)
+    if (finished[i].complete != NULL) finished[i].complete(finished[i].data);
+}
@@ -0,0 +1,38 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdbool.h>
+
+// Queued jobs of each priority and completions waiting for main thread, submit fails above it
+#define JOBS_MAX_IN_FLIGHT (16)
+
+typedef enum {
+  // Something on screen is waiting for the result
+  JOB_PRIORITY_HIGH,
+  JOB_PRIORITY_NORMAL,
+  // Results that are needed only later, e.g. assets of screens which are not shown yet
+  JOB_PRIORITY_LOW,
+  JOB_PRIORITY_COUNT
+} JobPriority;
+
+typedef void (*JobFunction)(void *data);
+
+typedef struct {
+  // Runs on worker thread, it must not touch state which main thread changes meanwhile
+  JobFunction run;
+  // Runs on main thread from jobs_complete once run has finished, can be NULL
+  JobFunction complete;
+  void *data;
+} Job;
+
+// Worker has lower priority than main thread, so jobs run only while main thread waits for vblank or GPU
+void jobs_init();
+// Runs all queued jobs and their completions before returning
+void jobs_destroy();
+
+// Returns false when job can't be queued, then caller has to do the work itself
+bool job_submit(JobPriority priority, Job job);
+// Called once per main loop iteration, it never waits for jobs that are still running
+void jobs_complete();
+
+#endif
@@ -1564,6 +1564,10 @@ Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_Text
         return &Clay__MeasureTextCacheItem_DEFAULT;
     }
     #endif
+    #ifdef CLAY_DISABLE_TEXT_MEASURE_CACHE
+    // NOT PART OF THE ORIGINAL LIBRARY: text is measured again in every layout and its words are kept only until the next one
+    uint32_t id = 0;
+    #else
     uint32_t id = Clay__HashStringContentsWithConfig(text, config);
     uint32_t hashBucket = id % (context->maxMeasureTextCacheWordCount / 32);
     int32_t elementIndexPrevious = 0;
@@ -1599,6 +1603,7 @@ Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_Text
             elementIndex = hashEntry->nextIndex;
         }
     }
+    #endif
 
     int32_t newItemIndex = 0;
     Clay__MeasureTextCacheItem newCacheItem = { .measuredWordsStartIndex = -1, .id = id, .generation = context->generation };
@@ -1680,11 +1685,13 @@ Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_Text
     measured->unwrappedDimensions.width = measuredWidth;
     measured->unwrappedDimensions.height = measuredHeight;
 
+    #ifndef CLAY_DISABLE_TEXT_MEASURE_CACHE
     if (elementIndexPrevious != 0) {
         Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, elementIndexPrevious)->nextIndex = newItemIndex;
     } else {
         context->measureTextHashMap.internalArray[hashBucket] = newItemIndex;
     }
+    #endif
     return measured;
 }
 
@@ -2485,7 +2492,12 @@ void Clay__CalculateFinalLayout(void) {
         textElementData->wrappedLines = CLAY__INIT(Clay__WrappedTextLineArraySlice) { .length = 0, .internalArray = &context->wrappedTextLines.internalArray[context->wrappedTextLines.length] };
         Clay_LayoutElement *containerElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)textElementData->elementIndex);
         Clay_TextElementConfig *textConfig = Clay__FindElementConfigWithType(containerElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig;
+        #ifdef CLAY_DISABLE_TEXT_MEASURE_CACHE
+        // NOT PART OF THE ORIGINAL LIBRARY: text elements were measured in the same order when they were opened
+        Clay__MeasureTextCacheItem *measureTextCacheItem = Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, textElementIndex + 1);
+        #else
         Clay__MeasureTextCacheItem *measureTextCacheItem = Clay__MeasureTextCached(&textElementData->text, textConfig);
+        #endif
         float lineWidth = 0;
         float lineHeight = textConfig->lineHeight > 0 ? (float)textConfig->lineHeight : textElementData->preferredDimensions.height;
         int32_t lineLengthChars = 0;
@@ -4159,6 +4171,11 @@ CLAY_WASM_EXPORT("Clay_BeginLayout")
 void Clay_BeginLayout(void) {
     Clay_Context* context = Clay_GetCurrentContext();
     Clay__InitializeEphemeralMemory(context);
+    #ifdef CLAY_DISABLE_TEXT_MEASURE_CACHE
+    // NOT PART OF THE ORIGINAL LIBRARY: measurements of previous layout are no longer needed
+    context->measuredWords.length = 0;
+    context->measureTextHashMapInternal.length = 1;
+    #endif
     context->generation++;
     context->dynamicElementIndex = 0;
     // Set up the root container that covers the entire window
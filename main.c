@@ -1,23 +1,25 @@
 #include <pspkernel.h>
+#include <stdio.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-#define CLAY_IMPLEMENTATION
-#include <clay.h>
-
+#include "card_cache.h"
+#include "compositor.h"
+#include "counters.h"
 #include "debug.h"
 #include "game.h"
 #include "gfx.h"
+#include "jobs.h"
 #include "renderer.h"
+#include "save.h"
+#include "scheduler.h"
 #include "state.h"
 #include "system.h"
 
 PSP_MODULE_INFO("Joker Poker", 0, 0, 40);
 PSP_MAIN_THREAD_ATTR(PSP_THREAD_ATTR_USER);
 
-static char __attribute__((aligned(16))) list[262144];
-
 State state;
 
 void init() {
@@ -25,16 +27,24 @@ void init() {
 
   setup_callbacks();
 
-  init_gu(list);
+  init_gu();
+  compositor_init(COMPOSITE_DIRTY_RECTS);
+  scheduler_init(DEFAULT_FRAME_PACING);
   renderer_init();
-
-  state.cards_atlas = load_texture("res/cards.png");
-  state.jokers_atlas1 = load_texture("res/jokers1.png");
-  state.jokers_atlas2 = load_texture("res/jokers2.png");
+  frame_arena_init();
+  jobs_init();
+  // Slots are kept next to EBOOT.PBP
+  save_init("");
+
+  // Main menu needs only font and logo, atlases are decoded while it is shown
+  state.cards_atlas = load_texture_async("res/cards.png");
+  state.jokers_atlas1 = load_texture_async("res/jokers1.png");
+  state.jokers_atlas2 = load_texture_async("res/jokers2.png");
   state.font = load_texture("res/font.png");
   state.logo = load_texture("res/logo.png");
 
   init_background();
+  card_cache_init();
 
   sceCtrlSetSamplingCycle(0);
   sceCtrlSetSamplingMode(PSP_CTRL_MODE_ANALOG);
@@ -46,7 +56,12 @@ void init() {
 }
 
 void destroy() {
+  jobs_destroy();
+  log_layout_stats();
+  counters_log();
+  card_cache_destroy();
   game_destroy();
+  frame_arena_destroy();
   end_gu();
 
   stbi_image_free(state.cards_atlas->data);
@@ -71,40 +86,93 @@ void destroy() {
 int main(int argc, char *argv[]) {
   init();
   uint64_t last_time = sceKernelGetSystemTimeWide();
-#ifdef DEBUG_BUILD
-  float frame_time = 0.0f;
-#endif
 
   log_message(LOG_INFO, "Starting main loop...");
 
   update_render_commands();
 
+  // Every iteration takes one vblank, input is polled in each of them even if nothing is drawn
   while (state.running) {
-    handle_controls();
-
     uint64_t curr_time = sceKernelGetSystemTimeWide();
 
     state.delta = (curr_time - last_time) / 1000000.0f;
     state.time += state.delta;
     last_time = curr_time;
 
-    state.frame_arena.offset = 0;
+    handle_controls();
+    scheduler_update(curr_time);
+    jobs_complete();
+
+    // Makes a single roll until the next Shop is ready, so entering the Shop doesn't have to roll it
+    prepare_next_shop();
 
-    start_frame(list);
+#ifdef DEBUG_BUILD
+    // Debug text changes with new busy time stats and after input
+    if (state.scheduler.has_new_stats || state.scheduler.idle_time == 0)
+      compositor_mark_dirty(&(Rect){340, 0, SCREEN_WIDTH - 340, 70});
+#endif
+
+    // Nothing has changed since draw buffer was drawn last time, so displayed frame is kept
+    Rect region;
+    if (!compositor_begin_frame(&region)) {
+      skip_frame();
+      continue;
+    }
+
+    start_frame(&region);
 
     render_background();
 
-    execute_render_commands(state.render_commands);
+    execute_render_commands(state.render_commands, &region);
 
 #ifdef DEBUG_BUILD
-    Clay_String fps_counter;
-    append_clay_string(&fps_counter, "%.2f FPS [%.2f ms]", 1 / state.delta, frame_time);
-    draw_text_len(fps_counter.chars, fps_counter.length, &(Vector2){360, 0}, 0xFFFFFFFF);
-
-    frame_time = (sceKernelGetSystemTimeWide() - curr_time) / 1000.0f;
+    // Drawn directly, so it does not use frame arena that has to outlive current layout
+    char debug_text[48];
+    int length = snprintf(debug_text, sizeof(debug_text), "%d FPS [%d Hz]", state.scheduler.frame_rate,
+                          state.scheduler.rate);
+    draw_text_len(debug_text, length, &(Vector2){340, 0}, 0xFFFFFFFF);
+
+    // Average busy time of drawn frames
+    length = snprintf(debug_text, sizeof(debug_text), "CPU %.2f GPU %.2f ms", state.scheduler.cpu_time,
+                      state.scheduler.gpu_time);
+    draw_text_len(debug_text, length, &(Vector2){340, 10}, 0xFFFFFFFF);
+
+    // Current, peak and average frame arena usage of current stage
+    FrameArenaStats *arena_stats = &state.frame_arena.stats[state.stage];
+    length = snprintf(debug_text, sizeof(debug_text), "Arena %zu/%zu/%llu", frame_arena_get_used(), arena_stats->peak,
+                      arena_stats->layouts > 0 ? (unsigned long long)(arena_stats->total / arena_stats->layouts) : 0);
+    draw_text_len(debug_text, length, &(Vector2){340, 20}, 0xFFFFFFFF);
+
+    // Peak element count of current stage and its budget
+    length = snprintf(debug_text, sizeof(debug_text), "Clay %d/%d", get_layout_peak()->elements,
+                      get_layout_budget()->elements);
+    draw_text_len(debug_text, length, &(Vector2){340, 30}, 0xFFFFFFFF);
+
+    // Engine work done by the last player action
+    uint32_t joker_triggers = 0;
+    for (CounterId id = COUNTER_JOKER_ON_PLAYED; id <= COUNTER_JOKER_ON_BLIND_SELECT; id++)
+      joker_triggers += get_counter_action(id);
+    length = snprintf(debug_text, sizeof(debug_text), "Eval %u Score %u Joker %u",
+                      get_counter_action(COUNTER_EVALUATE_HAND), get_counter_action(COUNTER_UPDATE_SCORING_HAND),
+                      joker_triggers);
+    draw_text_len(debug_text, length, &(Vector2){340, 40}, 0xFFFFFFFF);
+
+    // Random draws of each stream in RandomSubsystem order
+    length = snprintf(debug_text, sizeof(debug_text), "Rng %u/%u/%u/%u/%u/%u/%u/%u",
+                      get_counter_action(COUNTER_RANDOM_OTHER), get_counter_action(COUNTER_RANDOM_SHUFFLE),
+                      get_counter_action(COUNTER_RANDOM_SHOP), get_counter_action(COUNTER_RANDOM_BOOSTER_PACK),
+                      get_counter_action(COUNTER_RANDOM_TAG), get_counter_action(COUNTER_RANDOM_BOSS),
+                      get_counter_action(COUNTER_RANDOM_EDITION), get_counter_action(COUNTER_RANDOM_ENHANCEMENT));
+    draw_text_len(debug_text, length, &(Vector2){340, 50}, 0xFFFFFFFF);
+
+    length = snprintf(debug_text, sizeof(debug_text), "Vec %u", get_counter_action(COUNTER_VECTOR_REALLOCATIONS));
+    draw_text_len(debug_text, length, &(Vector2){340, 60}, 0xFFFFFFFF);
 #endif
 
-    end_frame();
+    // Only frames driven by animation at full rate are pipelined. Idle time is 0 in the iteration in which input has
+    // arrived, so frame drawn in response to it is shown right away, even though input also selects full rate.
+    end_frame(state.compositor.animation_interval == 1 && state.scheduler.idle_time > 0);
+    compositor_end_frame();
   }
 
   destroy();
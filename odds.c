@@ -0,0 +1,367 @@
+#include "odds.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "game.h"
+#include "gfx.h"
+#include "jobs.h"
+#include "random.h"
+#include "state.h"
+#include "vector.h"
+
+// Draws up to this size are enumerated exactly, bigger ones are sampled
+#define ODDS_MAX_EXACT_DRAW 5
+#define ODDS_BINOMIAL_MAX_N 512
+#define ODDS_SAMPLE_COUNT 512
+// Draws of this many samples are generated together, ODDS_SAMPLE_COUNT has to be its multiple
+#define ODDS_BATCH_SIZE 16
+
+// Bigger hands and decks get no odds
+#define ODDS_MAX_HAND_CARDS 32
+#define ODDS_MAX_DECK_CARDS 256
+
+// 13 ranks followed by stone cards, which have no rank
+#define ODDS_RANK_CATEGORIES 14
+#define ODDS_STONE 13
+// 4 suits followed by wild and stone cards
+#define ODDS_SUIT_CATEGORIES 6
+#define ODDS_WILD 4
+
+// Hands that depend on both ranks and suits of the same cards can't be derived
+// from separate rank and suit histograms, so those are always sampled
+#define ODDS_SAMPLED_HANDS (HAND_STRAIGHT_FLUSH | HAND_FLUSH_HOUSE | HAND_FLUSH_FIVE)
+
+typedef struct {
+  uint8_t rank;
+  uint8_t suit;
+} OddsCard;
+
+// Copy of everything odds depend on, so they can be computed on job thread while the game goes on
+typedef struct {
+  uint32_t key;
+  uint8_t kept_count;
+  // Exact odds enumerate rank and suit categories, samples add cards to histograms
+  OddsCard kept_cards[ODDS_MAX_HAND_CARDS];
+  HistogramCard kept_histogram_cards[ODDS_MAX_HAND_CARDS];
+  HandHistogram kept_histogram;
+  uint16_t deck_size;
+  HistogramCard deck_cards[ODDS_MAX_DECK_CARDS];
+  DeckCounts deck_counts;
+  DrawOdds odds;
+} OddsJob;
+
+typedef struct {
+  double terms[ODDS_RANK_CATEGORIES][ODDS_MAX_EXACT_DRAW + 1];
+  uint8_t counts[ODDS_RANK_CATEGORIES];
+  uint8_t wild_count;
+  double probability[12];
+} OddsEnumeration;
+
+static double binomials[ODDS_BINOMIAL_MAX_N + 1][ODDS_MAX_EXACT_DRAW + 1];
+static bool are_binomials_ready = false;
+
+static DrawOdds cached_odds;
+static uint32_t cached_odds_key = 0;
+static bool is_cached_odds_valid = false;
+
+static OddsJob odds_job;
+static bool is_odds_job_running = false;
+
+// Samples use stream which game never draws from, so displaying odds doesn't advance the game RNG
+#define ODDS_RANDOM_STREAM (RANDOM_SUBSYSTEM_COUNT)
+
+static double binomial(uint16_t n, uint8_t k) {
+  if (k > n) return 0;
+
+  if (n <= ODDS_BINOMIAL_MAX_N && k <= ODDS_MAX_EXACT_DRAW) {
+    if (!are_binomials_ready) {
+      for (uint16_t i = 0; i <= ODDS_BINOMIAL_MAX_N; i++) {
+        binomials[i][0] = 1;
+        for (uint8_t j = 1; j <= ODDS_MAX_EXACT_DRAW; j++)
+          binomials[i][j] = i == 0 ? 0 : binomials[i - 1][j - 1] + binomials[i - 1][j];
+      }
+      are_binomials_ready = true;
+    }
+
+    return binomials[n][k];
+  }
+
+  double result = 1;
+  for (uint8_t i = 0; i < k; i++) result = result * (n - i) / (i + 1);
+  return result;
+}
+
+static uint16_t get_rank_hands(const uint8_t *rank_counts) {
+  HandHistogram histogram = {0};
+  for (uint8_t rank = 0; rank < 13; rank++)
+    for (uint8_t i = 0; i < rank_counts[rank] && i < 5; i++) histogram.rank_planes[i] |= 1 << rank;
+
+  return get_histogram_hands(&histogram);
+}
+
+// Only few samples have a flush, so suited hands are evaluated again from cards of the flush suit
+static uint16_t get_flush_hands(const OddsJob *job, const uint16_t *drawn, uint8_t draw_count) {
+  HandHistogram histogram = job->kept_histogram;
+  for (uint8_t i = 0; i < draw_count; i++) add_histogram_card(&histogram, job->deck_cards[drawn[i]]);
+
+  uint16_t result = 0;
+  for (uint32_t lanes = get_flush_suit_lanes(&histogram); lanes != 0; lanes &= lanes - 1) {
+    uint32_t lane = lanes & -lanes;
+    HandHistogram suited = {0};
+
+    for (uint8_t i = 0; i < job->kept_count; i++)
+      if (job->kept_histogram_cards[i].suit_lanes & lane) add_histogram_card(&suited, job->kept_histogram_cards[i]);
+    for (uint8_t i = 0; i < draw_count; i++)
+      if (job->deck_cards[drawn[i]].suit_lanes & lane) add_histogram_card(&suited, job->deck_cards[drawn[i]]);
+
+    result |= get_suited_histogram_hands(&suited);
+  }
+
+  return result;
+}
+
+static OddsCard to_odds_card(const Card *card) {
+  if (card->enhancement == ENHANCEMENT_STONE) return (OddsCard){.rank = ODDS_STONE, .suit = ODDS_WILD + 1};
+
+  return (OddsCard){.rank = card->rank, .suit = card->enhancement == ENHANCEMENT_WILD ? ODDS_WILD : card->suit};
+}
+
+static void accumulate_hands(double *probability, uint16_t hands, double weight) {
+  for (uint8_t i = 0; i < 12; i++)
+    if (hands & (1 << i)) probability[i] += weight;
+}
+
+static void enumerate_rank_draws(OddsEnumeration *enumeration, uint8_t category, uint8_t remaining, double weight) {
+  // Stone cards are the last category and take all remaining draws
+  if (category == ODDS_STONE) {
+    weight *= enumeration->terms[category][remaining];
+    if (weight != 0) accumulate_hands(enumeration->probability, get_rank_hands(enumeration->counts), weight);
+    return;
+  }
+
+  for (uint8_t drawn = 0; drawn <= remaining; drawn++) {
+    double term = enumeration->terms[category][drawn];
+    // C(n, k) = 0 means there are not enough cards for any bigger k as well
+    if (term == 0) break;
+
+    enumeration->counts[category] += drawn;
+    enumerate_rank_draws(enumeration, category + 1, remaining - drawn, weight * term);
+    enumeration->counts[category] -= drawn;
+  }
+}
+
+static void enumerate_suit_draws(OddsEnumeration *enumeration, uint8_t category, uint8_t remaining, double weight) {
+  if (category == ODDS_SUIT_CATEGORIES - 1) {
+    weight *= enumeration->terms[category][remaining];
+    if (weight == 0) return;
+
+    for (uint8_t suit = 0; suit < 4; suit++) {
+      if (enumeration->counts[suit] + enumeration->counts[ODDS_WILD] + enumeration->wild_count >= 5) {
+        accumulate_hands(enumeration->probability, HAND_FLUSH, weight);
+        break;
+      }
+    }
+    return;
+  }
+
+  for (uint8_t drawn = 0; drawn <= remaining; drawn++) {
+    double term = enumeration->terms[category][drawn];
+    if (term == 0) break;
+
+    enumeration->counts[category] += drawn;
+    enumerate_suit_draws(enumeration, category + 1, remaining - drawn, weight * term);
+    enumeration->counts[category] -= drawn;
+  }
+}
+
+static void compute_exact_odds(DrawOdds *odds, const OddsJob *job) {
+  const OddsCard *kept_cards = job->kept_cards;
+  uint8_t kept_count = job->kept_count;
+  const DeckCounts *deck = &job->deck_counts;
+  uint8_t draw_count = odds->draw_count;
+  double total = binomial(deck->total, draw_count);
+  if (total == 0) return;
+
+  OddsEnumeration enumeration = {0};
+
+  for (uint8_t i = 0; i < kept_count; i++)
+    if (kept_cards[i].rank != ODDS_STONE) enumeration.counts[kept_cards[i].rank]++;
+
+  for (uint8_t rank = 0; rank < 13; rank++)
+    for (uint8_t drawn = 0; drawn <= draw_count; drawn++)
+      enumeration.terms[rank][drawn] = binomial(deck->playable_ranks[rank], drawn);
+  for (uint8_t drawn = 0; drawn <= draw_count; drawn++)
+    enumeration.terms[ODDS_STONE][drawn] = binomial(deck->enhancements[ENHANCEMENT_STONE], drawn);
+
+  enumerate_rank_draws(&enumeration, 0, draw_count, 1);
+
+  // Suit histogram is enumerated separately, starting from suits of kept cards
+  memset(enumeration.counts, 0, sizeof(enumeration.counts));
+  for (uint8_t i = 0; i < kept_count; i++) {
+    if (kept_cards[i].suit == ODDS_WILD)
+      enumeration.wild_count++;
+    else if (kept_cards[i].rank != ODDS_STONE)
+      enumeration.counts[kept_cards[i].suit]++;
+  }
+
+  uint16_t natural_cards = 0;
+  for (uint8_t suit = 0; suit < 4; suit++) natural_cards += deck->natural_suits[suit];
+
+  for (uint8_t drawn = 0; drawn <= draw_count; drawn++) {
+    for (uint8_t suit = 0; suit < 4; suit++) enumeration.terms[suit][drawn] = binomial(deck->natural_suits[suit], drawn);
+    enumeration.terms[ODDS_WILD][drawn] = binomial(deck->enhancements[ENHANCEMENT_WILD], drawn);
+    enumeration.terms[ODDS_WILD + 1][drawn] =
+        binomial(deck->total - natural_cards - deck->enhancements[ENHANCEMENT_WILD], drawn);
+  }
+
+  enumerate_suit_draws(&enumeration, 0, draw_count, 1);
+
+  for (uint8_t i = 0; i < 12; i++) {
+    if ((1 << i) & ODDS_SAMPLED_HANDS) continue;
+
+    odds->probability[i] = enumeration.probability[i] / total;
+    odds->error[i] = 0;
+  }
+}
+
+// Draws are seeded with odds key, so the same hand always gets the same estimate
+static void compute_sampled_odds(DrawOdds *odds, const OddsJob *job, uint16_t hands) {
+  uint8_t draw_count = odds->draw_count;
+  uint16_t deck_size = job->deck_size;
+
+  // Partial shuffle leaves a permutation behind, so the next sample can continue shuffling the same indices
+  uint16_t indices[deck_size];
+  for (uint16_t i = 0; i < deck_size; i++) indices[i] = i;
+
+  uint32_t draws[ODDS_BATCH_SIZE * draw_count];
+  uint16_t drawn[ODDS_BATCH_SIZE * draw_count];
+  uint16_t results[ODDS_BATCH_SIZE];
+  uint16_t hits[12] = {0};
+
+  for (uint16_t first_sample = 0; first_sample < ODDS_SAMPLE_COUNT; first_sample += ODDS_BATCH_SIZE) {
+    uint64_t position = (uint64_t)first_sample * draw_count;
+    random_fill_at(job->key, ODDS_RANDOM_STREAM, position, draws, ODDS_BATCH_SIZE * draw_count);
+
+    // Partial Fisher-Yates shuffle, only drawn cards need to be picked
+    for (uint16_t first = 0; first < ODDS_BATCH_SIZE * draw_count; first += draw_count) {
+      for (uint8_t i = 0; i < draw_count; i++) {
+        // Multiplication maps draw to the range without division, which is slow on PSP
+        uint16_t j = i + ((uint64_t)draws[first + i] * (deck_size - i) >> 32);
+        drawn[first + i] = indices[j];
+        indices[j] = indices[i];
+        indices[i] = drawn[first + i];
+      }
+    }
+
+    evaluate_histogram_batch(&job->kept_histogram, job->deck_cards, drawn, draw_count, ODDS_BATCH_SIZE, results);
+
+    for (uint8_t sample = 0; sample < ODDS_BATCH_SIZE; sample++) {
+      uint16_t found = results[sample];
+      if (found & HAND_FLUSH) found |= get_flush_hands(job, &drawn[sample * draw_count], draw_count);
+
+      // Only bits of found hands are visited
+      for (found &= hands; found != 0; found &= found - 1) hits[__builtin_ctz(found)]++;
+    }
+  }
+
+  for (uint8_t i = 0; i < 12; i++) {
+    if (!((1 << i) & hands)) continue;
+
+    float p = (float)hits[i] / ODDS_SAMPLE_COUNT;
+    odds->probability[i] = p;
+    // Rule of three for hands that never showed up
+    odds->error[i] = hits[i] == 0 || hits[i] == ODDS_SAMPLE_COUNT ? 3.0f / ODDS_SAMPLE_COUNT
+                                                                   : 1.96f * sqrtf(p * (1 - p) / ODDS_SAMPLE_COUNT);
+  }
+}
+
+static uint32_t get_draw_odds_key() {
+  // FNV-1a over everything that affects the result
+  uint32_t key = 2166136261u;
+  cvector_for_each(state.game.hand.cards, Card, card) {
+    uint32_t values[] = {card->id, card->rank, card->suit, card->enhancement, card->selected};
+    for (uint8_t i = 0; i < 5; i++) key = (key ^ values[i]) * 16777619u;
+  }
+
+  key = (key ^ state.game.hand.size) * 16777619u;
+  key = (key ^ state.game.deck_counts.total) * 16777619u;
+  return key;
+}
+
+// Draw count is set together with the copied inputs
+static void compute_draw_odds(OddsJob *job) {
+  DrawOdds *odds = &job->odds;
+  uint8_t draw_count = odds->draw_count;
+
+  if (draw_count == 0) {
+    uint16_t result = get_histogram_hands(&job->kept_histogram);
+    if (result & HAND_FLUSH) result |= get_flush_hands(job, NULL, 0);
+    for (uint8_t i = 0; i < 12; i++) odds->probability[i] = (result & (1 << i)) ? 1 : 0;
+  } else if (draw_count <= ODDS_MAX_EXACT_DRAW) {
+    compute_exact_odds(odds, job);
+    compute_sampled_odds(odds, job, ODDS_SAMPLED_HANDS);
+  } else {
+    compute_sampled_odds(odds, job, 0xFFF);
+  }
+}
+
+static bool copy_odds_inputs(OddsJob *job, uint32_t key) {
+  uint8_t kept_count = 0;
+  cvector_for_each(state.game.hand.cards, Card, card) if (card->selected == 0) kept_count++;
+  if (kept_count > ODDS_MAX_HAND_CARDS || cvector_size(state.game.deck) > ODDS_MAX_DECK_CARDS) return false;
+
+  job->key = key;
+  job->kept_count = 0;
+  job->kept_histogram = (HandHistogram){0};
+  cvector_for_each(state.game.hand.cards, Card, card) {
+    if (card->selected != 0) continue;
+
+    job->kept_cards[job->kept_count] = to_odds_card(card);
+    job->kept_histogram_cards[job->kept_count] = to_histogram_card(card);
+    add_histogram_card(&job->kept_histogram, job->kept_histogram_cards[job->kept_count]);
+    job->kept_count++;
+  }
+
+  job->deck_size = cvector_size(state.game.deck);
+  for (uint16_t i = 0; i < job->deck_size; i++) job->deck_cards[i] = to_histogram_card(&state.game.deck[i]);
+  job->deck_counts = state.game.deck_counts;
+
+  uint8_t draw_count = state.game.hand.size > kept_count ? state.game.hand.size - kept_count : 0;
+  if (draw_count > state.game.deck_counts.total) draw_count = state.game.deck_counts.total;
+  job->odds = (DrawOdds){.draw_count = draw_count};
+  return true;
+}
+
+static void run_odds_job(void *data) { compute_draw_odds(data); }
+
+static void store_odds(const OddsJob *job) {
+  cached_odds = job->odds;
+  cached_odds_key = job->key;
+  is_cached_odds_valid = true;
+}
+
+static void complete_odds_job(void *data) {
+  store_odds(data);
+  is_odds_job_running = false;
+
+  // Odds are shown as part of the layout, so it is rebuilt once they are ready
+  if (state.stage == STAGE_GAME) update_render_commands();
+}
+
+const DrawOdds *get_draw_odds() {
+  uint32_t key = get_draw_odds_key();
+  if (is_cached_odds_valid && key == cached_odds_key) return &cached_odds;
+
+  // Odds of previous selection would be misleading, so there are none until the job for this one is done
+  if (is_odds_job_running || !copy_odds_inputs(&odds_job, key)) return NULL;
+
+  Job job = {.run = run_odds_job, .complete = complete_odds_job, .data = &odds_job};
+  is_odds_job_running = job_submit(JOB_PRIORITY_HIGH, job);
+  if (is_odds_job_running) return NULL;
+
+  compute_draw_odds(&odds_job);
+  store_odds(&odds_job);
+  return &cached_odds;
+}
@@ -0,0 +1,18 @@
+#ifndef ODDS_H
+#define ODDS_H
+
+#include <stdint.h>
+
+typedef struct {
+  // Indexed the same way as poker_hands, probability that hand after discarding
+  // selected cards and refilling it from the deck contains given poker hand
+  float probability[12];
+  // 95% confidence half-width, 0 for values computed exactly
+  float error[12];
+  uint8_t draw_count;
+} DrawOdds;
+
+// Returns NULL while odds of current selection are computed on job thread
+const DrawOdds *get_draw_odds();
+
+#endif
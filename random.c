@@ -1,27 +1,136 @@
 #include "random.h"
 
-#include <stdlib.h>
 #include <time.h>
 
-#include "cvector.h"
-#include "game.h"
-#include "state.h"
+#include "counters.h"
+#include "vector.h"
 
-void rng_init() { srand(time((NULL))); }
+// Every ante gets 2^32 draws of each stream
+#define RANDOM_ANTE_SHIFT (32)
 
-int16_t random_filtered_range_pick(uint8_t start, uint8_t end, RangeFilter filter) {
-  if (start > end) return -1;
+// Squares generator (Widynski), draw is a function of stream key and its position only, so moving stream to any
+// position is O(1) and the same seed gives the same run on PSP and on PC
+typedef struct {
+  uint64_t key;
+  uint64_t counter;
+} RandomStream;
+
+static RandomSubsystem random_subsystem = RANDOM_SUBSYSTEM_OTHER;
+
+static RandomStream streams[RANDOM_SUBSYSTEM_COUNT];
+static uint32_t random_seed = 0;
+
+static uint32_t squares(uint64_t counter, uint64_t key) {
+  uint64_t x = counter * key;
+  uint64_t y = x;
+  uint64_t z = y + key;
+
+  x = x * x + y;
+  x = (x >> 32) | (x << 32);
+  x = x * x + z;
+  x = (x >> 32) | (x << 32);
+  x = x * x + y;
+  x = (x >> 32) | (x << 32);
+  return (x * x + z) >> 32;
+}
+
+// SplitMix64 finalizer, spreads seed and stream index over the whole key
+static uint64_t mix_key(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+static uint64_t get_stream_key(uint32_t seed, uint8_t stream) {
+  // Squares needs odd key
+  return mix_key((uint64_t)seed << 8 | stream) | 1;
+}
+
+static uint32_t next_random() {
+  RandomStream *stream = &streams[random_subsystem];
+  return squares(stream->counter++, stream->key);
+}
+
+uint32_t get_new_run_seed() {
+#ifdef RUN_SEED
+  return RUN_SEED;
+#else
+  return time(NULL);
+#endif
+}
+
+void set_random_seed(uint32_t seed) {
+  random_seed = seed;
+
+  for (uint8_t i = 0; i < RANDOM_SUBSYSTEM_COUNT; i++) streams[i] = (RandomStream){.key = get_stream_key(seed, i)};
+}
+
+uint32_t get_random_seed() { return random_seed; }
+
+void advance_random_streams(uint8_t ante) {
+  for (uint8_t i = 0; i < RANDOM_SUBSYSTEM_COUNT; i++) streams[i].counter = get_random_advanced_position(i, ante);
+}
+
+uint64_t get_random_position(RandomSubsystem subsystem) { return streams[subsystem].counter; }
+
+void set_random_position(RandomSubsystem subsystem, uint64_t position) { streams[subsystem].counter = position; }
+
+uint64_t get_random_advanced_position(RandomSubsystem subsystem, uint8_t ante) {
+  uint64_t counter = (uint64_t)ante << RANDOM_ANTE_SHIFT;
+  return streams[subsystem].counter < counter ? counter : streams[subsystem].counter;
+}
+
+RandomSubsystem set_random_subsystem(RandomSubsystem subsystem) {
+  RandomSubsystem previous = random_subsystem;
+  random_subsystem = subsystem;
+  return previous;
+}
+
+uint32_t random_at(uint32_t seed, uint8_t stream, uint64_t position) {
+  return squares(position, get_stream_key(seed, stream));
+}
+
+void random_fill_at(uint32_t seed, uint8_t stream, uint64_t position, uint32_t *draws, uint16_t count) {
+  uint64_t key = get_stream_key(seed, stream);
+  for (uint16_t i = 0; i < count; i++) draws[i] = squares(position + i, key);
+}
+
+static uint32_t random_draw() {
+  COUNTER_INC(COUNTER_RANDOM_OTHER + random_subsystem);
+  return next_random() >> 1;
+}
+
+void random_fill(uint32_t *draws, uint16_t count) {
+  RandomStream *stream = &streams[random_subsystem];
+  COUNTER_ADD(COUNTER_RANDOM_OTHER + random_subsystem, count);
+
+  // Positions are known up front, so iterations don't depend on each other
+  uint64_t counter = stream->counter;
+  for (uint16_t i = 0; i < count; i++) draws[i] = squares(counter + i, stream->key) >> 1;
+  stream->counter += count;
+}
+
+uint8_t random_draw_scaled(uint32_t draw, uint8_t max_value) { return draw / (RANDOM_MAX / (max_value + 1) + 1); }
+
+int16_t random_mask_pick(uint64_t mask) {
+  if (mask == 0) return -1;
 
-  uint8_t candidates[end - start + 1];
-  uint8_t count = 0;
+  // Lowest set bits are cleared until the picked one becomes the lowest
+  for (uint8_t skipped = random_max_value(__builtin_popcountll(mask) - 1); skipped > 0; skipped--) mask &= mask - 1;
 
+  return __builtin_ctzll(mask);
+}
+
+int16_t random_filtered_range_pick(uint8_t start, uint8_t end, RangeFilter filter) {
+  if (start > end || end - start >= 64) return -1;
+
+  uint64_t candidates = 0;
   for (uint8_t i = start; i <= end; i++) {
-    if (!filter || filter(i)) candidates[count++] = i;
+    if (!filter || filter(i)) candidates |= 1ull << (i - start);
   }
 
-  if (count == 0) return -1;
-
-  return candidates[random_max_value(count - 1)];
+  int16_t index = random_mask_pick(candidates);
+  return index < 0 ? -1 : start + index;
 }
 
 int16_t random_filtered_vector_pick(cvector_vector_type(void) vec, RangeFilter filter) {
@@ -39,7 +148,7 @@ int16_t random_weighted(uint16_t *weights, uint8_t count) {
 
   if (total_weight <= 0) return -1;
 
-  float random_value = ((double)rand() / RAND_MAX) * total_weight;
+  float random_value = ((double)random_draw() / RANDOM_MAX) * total_weight;
 
   total_weight = 0.0f;
   for (uint8_t i = 0; i < count; i++) {
@@ -50,113 +159,87 @@ int16_t random_weighted(uint16_t *weights, uint8_t count) {
   return -1;
 }
 
-bool random_percent(float probability) {
-  if (probability <= 0.0) return false;
-  if (probability >= 1.0) return true;
+void build_alias_table(AliasTable *table, const uint16_t *weights, uint8_t count) {
+  uint32_t total_weight = 0;
+  for (uint8_t i = 0; i < count; i++) total_weight += weights[i];
 
-  float random_value = rand() / (float)RAND_MAX;
-  return random_value < probability;
-}
+  table->count = total_weight > 0 ? count : 0;
+  if (table->count == 0) return;
 
-bool random_chance(uint8_t numerator, uint8_t denominator) {
-  if (numerator <= 0 || denominator <= 0) return 0;
-  if (numerator >= denominator) return 1;
+  // Weights are scaled by count, so each column holds exactly total weight and integer math stays exact
+  uint32_t scaled_weights[count];
+  uint8_t small[count], large[count];
+  uint8_t small_count = 0, large_count = 0;
 
-  return random_max_value(denominator - 1) < numerator;
-}
+  for (uint8_t i = 0; i < count; i++) {
+    scaled_weights[i] = weights[i] * count;
+    if (scaled_weights[i] < total_weight)
+      small[small_count++] = i;
+    else
+      large[large_count++] = i;
+  }
 
-uint8_t random_max_value(uint8_t max_value) { return random_in_range(0, max_value); }
+  // Every small column is topped up by one large column, which then might become small itself
+  while (small_count > 0 && large_count > 0) {
+    uint8_t small_index = small[--small_count];
+    uint8_t large_index = large[--large_count];
 
-uint8_t random_in_range(uint8_t min_value, uint8_t max_value) {
-  return min_value + rand() / (RAND_MAX / (max_value - min_value + 1) + 1);
-}
-
-Joker random_weighted_joker(uint16_t rarity_weights[4]) {
-  uint16_t weights[JOKER_COUNT];
-  bool has_any_weights = false;
-
-  for (uint8_t i = 0; i < JOKER_COUNT; i++) {
-    bool has_this_joker = false;
-    cvector_for_each(state.game.jokers.cards, Joker, joker) {
-      if (joker->id == JOKERS[i].id) {
-        has_this_joker = true;
-        break;
-      }
-    }
-
-    if (has_this_joker) {
-      weights[i] = 0;
-      continue;
-    }
-
-    weights[i] = rarity_weights[JOKERS[i].rarity];
-    has_any_weights = true;
-  };
-
-  // TODO According to Wiki "Joker" is returned when there are no more Jokers available and this should be changed when
-  // more jokers will be added
-  // Allow duplicates if there are no more jokers available
-  if (!has_any_weights)
-    for (uint8_t i = 0; i < JOKER_COUNT; i++) weights[i] = rarity_weights[JOKERS[i].rarity];
-
-  Joker joker = JOKERS[random_weighted(weights, JOKER_COUNT)];
-
-  // Base, Foil, Holographic, Polychrome, Negative
-  uint16_t edition_weights[5] = {960, 20, 14, 3, 3};
-  for (uint8_t i = 1; i < 4; i++) {
-    uint8_t multiplier = 1;
-    if (state.game.vouchers & VOUCHER_GLOW_UP)
-      multiplier = i == 3 ? 7 : 4;
-    else if (state.game.vouchers & VOUCHER_HONE)
-      multiplier = i == 3 ? 3 : 2;
-
-    edition_weights[0] -= (multiplier - 1) * edition_weights[i];
-    edition_weights[i] *= multiplier;
+    table->thresholds[small_index] = scaled_weights[small_index] * ALIAS_TABLE_RANGE / total_weight;
+    table->aliases[small_index] = large_index;
+
+    scaled_weights[large_index] -= total_weight - scaled_weights[small_index];
+    if (scaled_weights[large_index] < total_weight)
+      small[small_count++] = large_index;
+    else
+      large[large_count++] = large_index;
   }
-  joker.edition = random_weighted(edition_weights, 5);
 
-  return joker;
+  while (large_count > 0) {
+    uint8_t index = large[--large_count];
+    table->thresholds[index] = ALIAS_TABLE_RANGE;
+    table->aliases[index] = index;
+  }
+  while (small_count > 0) {
+    uint8_t index = small[--small_count];
+    table->thresholds[index] = ALIAS_TABLE_RANGE;
+    table->aliases[index] = index;
+  }
 }
 
-Joker random_available_joker() {
-  // Common, Uncommon, Rare, Legendary
-  uint16_t rarity_weights[] = {70, 25, 5, 0};
-  return random_weighted_joker(rarity_weights);
-}
+bool update_alias_table_key(CachedAliasTable *cached_table, uint32_t key) {
+  if (cached_table->is_built && cached_table->key == key) return false;
 
-Joker random_available_joker_by_rarity(Rarity rarity) {
-  // Common, Uncommon, Rare, Legendary
-  uint16_t base_rarity_weights[] = {70, 25, 5, 0};
-  uint16_t rarity_weights[4] = {0};
-  rarity_weights[rarity] = base_rarity_weights[rarity];
-  return random_weighted_joker(rarity_weights);
+  cached_table->key = key;
+  cached_table->is_built = true;
+  return true;
 }
 
-Card random_card() {
-  uint16_t edition_weights[5] = {920, 12, 28, 40, 0};
-  for (uint8_t i = 1; i < 4; i++) {
-    uint8_t multiplier = (state.game.vouchers & VOUCHER_GLOW_UP) ? 4 : (state.game.vouchers & VOUCHER_HONE) ? 2 : 1;
-    edition_weights[0] -= (multiplier - 1) * edition_weights[i];
-    edition_weights[i] *= multiplier;
-  }
-  Edition edition = random_weighted(edition_weights, 5);
-  Enhancement enhancement = ENHANCEMENT_NONE;
-  Seal seal = SEAL_NONE;
+int16_t random_alias(const AliasTable *table) {
+  if (table->count == 0) return -1;
 
-  if (random_chance(4, 10)) enhancement = random_in_range(ENHANCEMENT_BONUS, ENHANCEMENT_LUCKY);
-  if (random_chance(2, 10)) seal = random_in_range(SEAL_GOLD, SEAL_PURPLE);
+  uint64_t value = (uint64_t)random_draw() * table->count;
+  uint8_t column = value / ALIAS_TABLE_RANGE;
+
+  return value % ALIAS_TABLE_RANGE < table->thresholds[column] ? column : table->aliases[column];
+}
+
+bool random_percent(float probability) {
+  if (probability <= 0.0) return false;
+  if (probability >= 1.0) return true;
 
-  return create_card(random_max_value(3), random_max_value(12), edition, enhancement, seal);
+  float random_value = random_draw() / (float)RANDOM_MAX;
+  return random_value < probability;
 }
 
-Card random_shop_card() {
-  if (!(state.game.vouchers & VOUCHER_ILLUSION))
-    return create_card(random_max_value(3), random_max_value(12), EDITION_BASE, ENHANCEMENT_NONE, SEAL_NONE);
+bool random_chance(uint8_t numerator, uint8_t denominator) {
+  if (numerator <= 0 || denominator <= 0) return 0;
+  if (numerator >= denominator) return 1;
 
-  Card card = random_card();
-  card.edition = EDITION_BASE;
+  return random_max_value(denominator - 1) < numerator;
+}
 
-  if (random_chance(2, 10)) card.edition = random_in_range(EDITION_FOIL, EDITION_POLYCHROME);
+uint8_t random_max_value(uint8_t max_value) { return random_draw_scaled(random_draw(), max_value); }
 
-  return card;
+uint8_t random_in_range(uint8_t min_value, uint8_t max_value) {
+  return min_value + random_draw_scaled(random_draw(), max_value - min_value);
 }
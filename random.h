@@ -3,29 +3,94 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 
-#include "cvector.h"
-#include "game.h"
+#include "vector.h"
 
 #define random_vector_index(vec) random_max_value(cvector_size(vec) - 1)
 #define random_vector_item(vec) vec[random_vector_index(vec)]
 
+// Draws are 31 bits wide, same as rand() on PSP
+#define RANDOM_MAX (0x7FFFFFFF)
+
+// Enough for every joker, which is the largest distribution
+#define ALIAS_TABLE_MAX_SIZE (UINT8_MAX)
+// Single draw picks both column and position within it, thresholds are scaled to this range
+#define ALIAS_TABLE_RANGE ((uint64_t)RANDOM_MAX + 1)
+
 typedef bool (*RangeFilter)(uint8_t index);
 
-void rng_init();
+// Precomputed weighted distribution (Vose's alias method), so each roll is O(1) no matter how many items there are
+typedef struct {
+  // 0 when all weights are 0
+  uint8_t count;
+  // Roll stays in its column when its position is below threshold, otherwise it goes to alias of the column
+  uint32_t thresholds[ALIAS_TABLE_MAX_SIZE];
+  uint8_t aliases[ALIAS_TABLE_MAX_SIZE];
+} AliasTable;
+
+// Alias table together with inputs it was built from, so it is rebuilt only when they change
+typedef struct {
+  AliasTable table;
+  uint32_t key;
+  bool is_built;
+} CachedAliasTable;
+
+// Each subsystem draws from its own stream, so extra draws in one of them don't change rolls of the others.
+// Draws are also counted separately for each subsystem, see COUNTER_RANDOM_OTHER
+typedef enum {
+  RANDOM_SUBSYSTEM_OTHER,
+  RANDOM_SUBSYSTEM_SHUFFLE,
+  RANDOM_SUBSYSTEM_SHOP,
+  RANDOM_SUBSYSTEM_BOOSTER_PACK,
+  RANDOM_SUBSYSTEM_TAG,
+  RANDOM_SUBSYSTEM_BOSS,
+  // Editions of rolled jokers and cards
+  RANDOM_SUBSYSTEM_EDITION,
+  // Glass and Lucky Cards
+  RANDOM_SUBSYSTEM_ENHANCEMENT,
+  RANDOM_SUBSYSTEM_COUNT
+} RandomSubsystem;
 
+// Current time, or RUN_SEED when the game was built with it
+uint32_t get_new_run_seed();
+// Same seed always gives the same sequence of draws, so whole run can be replayed or searched for offline
+void set_random_seed(uint32_t seed);
+uint32_t get_random_seed();
+// Moves every stream to the part reserved for given ante, so draws made during one ante never shift rolls of the
+// next one. Streams which are already past it stay where they are, so antes repeated after Hieroglyph roll new items.
+void advance_random_streams(uint8_t ante);
+// Position of the next draw of given subsystem, lets rolls made ahead of time restore stream to where it was
+uint64_t get_random_position(RandomSubsystem subsystem);
+void set_random_position(RandomSubsystem subsystem, uint64_t position);
+// Position of the next draw of given subsystem once advance_random_streams(ante) is called
+uint64_t get_random_advanced_position(RandomSubsystem subsystem, uint8_t ante);
+// Selects subsystem which following draws come from, returns previously selected one
+RandomSubsystem set_random_subsystem(RandomSubsystem subsystem);
+
+// Draw at given position of a stream, depends on nothing else, so independent simulations can share a seed without
+// any synchronization. Streams past RANDOM_SUBSYSTEM_COUNT are never used by the game.
+uint32_t random_at(uint32_t seed, uint8_t stream, uint64_t position);
+// Same as calling random_at for count consecutive positions
+void random_fill_at(uint32_t seed, uint8_t stream, uint64_t position, uint32_t *draws, uint16_t count);
+// Fills buffer with next draws of selected subsystem, same as calling random_draw_scaled on each of them
+void random_fill(uint32_t *draws, uint16_t count);
+// Scales draw from random_fill to range from 0 to max_value, same as random_max_value
+uint8_t random_draw_scaled(uint32_t draw, uint8_t max_value);
+
+// Picks index of one of set bits
+int16_t random_mask_pick(uint64_t mask);
+// Range can hold at most 64 items
 int16_t random_filtered_range_pick(uint8_t start, uint8_t end, RangeFilter filter);
 int16_t random_filtered_vector_pick(cvector_vector_type(void) vec, RangeFilter filter);
 int16_t random_weighted(uint16_t *weights, uint8_t count);
+void build_alias_table(AliasTable *table, const uint16_t *weights, uint8_t count);
+// Returns true when table has to be built again for given inputs
+bool update_alias_table_key(CachedAliasTable *cached_table, uint32_t key);
+int16_t random_alias(const AliasTable *table);
 bool random_percent(float probability);
 bool random_chance(uint8_t numerator, uint8_t denominator);
 uint8_t random_max_value(uint8_t max_value);
 uint8_t random_in_range(uint8_t min_value, uint8_t max_value);
 
-Joker random_available_joker();
-Joker random_available_joker_by_rarity(Rarity rarity);
-
-Card random_card();
-Card random_shop_card();
-
 #endif
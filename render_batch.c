@@ -0,0 +1,16 @@
+#include "render_batch.h"
+
+void reserve_render_batch(RenderBatch *batch, char *list, int used) {
+  used += GU_MEMORY_HEADER_SIZE;
+  int available = DISPLAY_LIST_SIZE - DISPLAY_LIST_RESERVE - used;
+
+  batch->vertices = (Vertex *)&list[used];
+  batch->capacity = available > 0 ? available / sizeof(Vertex) : 0;
+}
+
+bool commit_render_batch(RenderBatch *batch, Vertex *memory) {
+  if (memory == batch->vertices) return true;
+
+  batch->count = 0;
+  return false;
+}
@@ -0,0 +1,17 @@
+#ifndef RENDER_BATCH_H
+#define RENDER_BATCH_H
+
+#include <stdbool.h>
+
+#include "system.h"
+
+// Where render batch lives in display list memory. GU calls that move the list stay in system.c,
+// so batches can be tested against any list allocator.
+
+// Batch starts right behind `used` bytes of the list and the header that sceGuGetMemory will place there
+void reserve_render_batch(RenderBatch *batch, char *list, int used);
+// Points batch to `memory` returned by sceGuGetMemory. Returns false when list has grown since batch was reserved,
+// commands added since then could have overwritten any of the vertices, so the batch is dropped.
+bool commit_render_batch(RenderBatch *batch, Vertex *memory);
+
+#endif
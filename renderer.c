@@ -3,11 +3,18 @@
 #include <clay.h>
 #include <stdio.h>
 
+#include "compositor.h"
 #include "debug.h"
 #include "gfx.h"
 #include "state.h"
 #include "system.h"
 
+// Implementation is compiled here, so layout statistics can be read from Clay context.
+// Font is monospace, so measuring text again is cheaper than hashing it for a cache lookup.
+#define CLAY_DISABLE_TEXT_MEASURE_CACHE
+#define CLAY_IMPLEMENTATION
+#include <clay.h>
+
 #define CLAY_COLOR_TO_PSP(color) RGBA((uint8_t)(color.r), (uint8_t)(color.g), (uint8_t)(color.b), (uint8_t)(color.a))
 
 void error_handler(Clay_ErrorData error) {
@@ -19,8 +26,42 @@ static inline Clay_Dimensions measure_text(Clay_StringSlice text, Clay_TextEleme
   return (Clay_Dimensions){.width = text.length * CHAR_WIDTH, .height = CHAR_HEIGHT};
 }
 
+// Highest counts measured for every stage and overlay with some headroom on top
+static const LayoutCounts layout_budgets[LAYOUT_SLOT_COUNT] = {
+    [STAGE_MAIN_MENU] = {32, 16, 640, 512},
+    [STAGE_SELECT_DECK] = {32, 16, 640, 512},
+    [STAGE_CREDITS] = {32, 16, 640, 512},
+    [STAGE_GAME] = {128, 48, 640, 512},
+    [STAGE_CASH_OUT] = {96, 48, 640, 512},
+    [STAGE_SHOP] = {128, 64, 640, 512},
+    [STAGE_BOOSTER_PACK] = {128, 48, 640, 512},
+    [STAGE_SELECT_BLIND] = {128, 64, 640, 512},
+    [STAGE_GAME_OVER] = {32, 16, 640, 512},
+    [STAGE_COUNT + OVERLAY_MENU] = {128, 48, 640, 512},
+    [STAGE_COUNT + OVERLAY_SELECT_STAKE] = {32, 16, 640, 512},
+    [STAGE_COUNT + OVERLAY_POKER_HANDS] = {384, 160, 640, 512},
+};
+
+static LayoutCounts layout_peaks[LAYOUT_SLOT_COUNT];
+
+static uint8_t get_layout_slot() { return state.overlay != OVERLAY_NONE ? STAGE_COUNT + state.overlay : state.stage; }
+
 void renderer_init() {
+#ifdef CLAY_BUDGET_SIZING
+  // Size Clay arena for the most demanding layout, id hash map shares its capacity with elements
+  uint16_t max_elements = 0;
+  uint16_t max_measured_words = 0;
+  for (uint8_t i = 0; i < LAYOUT_SLOT_COUNT; i++) {
+    if (layout_budgets[i].elements > max_elements) max_elements = layout_budgets[i].elements;
+    if (layout_budgets[i].element_ids > max_elements) max_elements = layout_budgets[i].element_ids;
+    if (layout_budgets[i].measured_words > max_measured_words) max_measured_words = layout_budgets[i].measured_words;
+  }
+
+  Clay_SetMaxElementCount(max_elements);
+  Clay_SetMaxMeasureTextCacheWordCount(max_measured_words);
+#else
   Clay_SetMaxElementCount(1024);
+#endif
   uint64_t total_memory = Clay_MinMemorySize();
   Clay_Arena arena = Clay_CreateArenaWithCapacityAndMemory(total_memory, malloc(total_memory));
   Clay_Initialize(arena, (Clay_Dimensions){SCREEN_WIDTH, SCREEN_HEIGHT}, (Clay_ErrorHandler){error_handler});
@@ -30,11 +71,65 @@ void renderer_init() {
   Clay_SetMeasureTextFunction(measure_text, NULL);
 }
 
-void execute_render_commands(Clay_RenderCommandArray render_commands) {
+bool is_over_layout_budget(const LayoutCounts *counts, const LayoutCounts *budget) {
+  return counts->elements > budget->elements || counts->text_elements > budget->text_elements ||
+         counts->element_ids > budget->element_ids || counts->measured_words > budget->measured_words;
+}
+
+void update_layout_stats() {
+  Clay_Context *context = Clay_GetCurrentContext();
+  uint8_t slot = get_layout_slot();
+  LayoutCounts *peak = &layout_peaks[slot];
+  const LayoutCounts *budget = &layout_budgets[slot];
+
+  LayoutCounts counts = {
+      .elements = context->layoutElements.length,
+      .text_elements = context->textElementData.length,
+      .element_ids = context->layoutElementsHashMapInternal.length,
+      .measured_words = context->measuredWords.length,
+  };
+
+  // Layout is checked against budget only when it raises the peak, so it isn't reported on every frame
+  if (!is_over_layout_budget(&counts, peak)) return;
+
+  if (counts.elements > peak->elements) peak->elements = counts.elements;
+  if (counts.text_elements > peak->text_elements) peak->text_elements = counts.text_elements;
+  if (counts.element_ids > peak->element_ids) peak->element_ids = counts.element_ids;
+  if (counts.measured_words > peak->measured_words) peak->measured_words = counts.measured_words;
+
+  if (!is_over_layout_budget(peak, budget)) return;
+
+  log_message(LOG_ERROR, "Layout peak of slot %d is over budget: %d/%d elements, %d/%d texts, %d/%d ids, %d/%d words.",
+              slot, peak->elements, budget->elements, peak->text_elements, budget->text_elements, peak->element_ids,
+              budget->element_ids, peak->measured_words, budget->measured_words);
+}
+
+void log_layout_stats() {
+  for (uint8_t i = 0; i < LAYOUT_SLOT_COUNT; i++) {
+    LayoutCounts *peak = &layout_peaks[i];
+    if (peak->elements == 0) continue;
+
+    log_message(LOG_INFO, "Layout slot %d peak: %d elements, %d texts, %d ids, %d words.", i, peak->elements,
+                peak->text_elements, peak->element_ids, peak->measured_words);
+  }
+}
+
+const LayoutCounts *get_layout_peak() { return &layout_peaks[get_layout_slot()]; }
+
+const LayoutCounts *get_layout_budget() { return &layout_budgets[get_layout_slot()]; }
+
+const LayoutCounts *get_layout_slot_peak(uint8_t slot) { return &layout_peaks[slot]; }
+
+const LayoutCounts *get_layout_slot_budget(uint8_t slot) { return &layout_budgets[slot]; }
+
+void execute_render_commands(Clay_RenderCommandArray render_commands, Rect *region) {
   for (int i = 0; i < render_commands.length; i++) {
     Clay_RenderCommand *render_command = Clay_RenderCommandArray_Get(&render_commands, i);
     Clay_BoundingBox bounding_box = render_command->boundingBox;
 
+    // Scissor would discard it anyway, but skipping it saves building its vertices
+    if (!is_region_visible(region, &bounding_box)) continue;
+
     switch (render_command->commandType) {
       case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
         Clay_RectangleRenderData *config = &render_command->renderData.rectangle;
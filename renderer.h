@@ -4,6 +4,7 @@
 #include <clay.h>
 
 #include "game.h"
+#include "state.h"
 
 typedef enum {
   CUSTOM_ELEMENT_CARD,
@@ -26,7 +27,25 @@ typedef struct __attribute__((aligned(16))) {
   };
 } CustomElementData;
 
+// Layout statistics are kept separately for every stage and overlay, overlay slots follow stage ones
+#define LAYOUT_SLOT_COUNT (STAGE_COUNT + OVERLAY_COUNT)
+
+typedef struct {
+  uint16_t elements;
+  uint16_t text_elements;
+  // Clay keeps these between layouts, so they depend on the whole session rather than a single layout
+  uint16_t element_ids;
+  uint16_t measured_words;
+} LayoutCounts;
+
 void renderer_init();
-void execute_render_commands(Clay_RenderCommandArray render_commands);
+void update_layout_stats();
+void log_layout_stats();
+const LayoutCounts *get_layout_peak();
+const LayoutCounts *get_layout_budget();
+const LayoutCounts *get_layout_slot_peak(uint8_t slot);
+const LayoutCounts *get_layout_slot_budget(uint8_t slot);
+bool is_over_layout_budget(const LayoutCounts *counts, const LayoutCounts *budget);
+void execute_render_commands(Clay_RenderCommandArray render_commands, Rect *region);
 
 #endif
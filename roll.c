@@ -0,0 +1,390 @@
+#include "roll.h"
+
+#include <string.h>
+
+#include "random.h"
+
+typedef struct {
+  AliasTable table;
+  // Table excludes these jokers, so it is rebuilt only when they are bought, sold or destroyed
+  uint32_t owned_jokers[JOKER_ID_WORDS];
+  bool is_built;
+} JokerDistribution;
+
+// One distribution for each rarity and the last one for all of them
+static JokerDistribution joker_distributions[RARITY_LEGENDARY + 2];
+static CachedAliasTable joker_edition_table;
+static CachedAliasTable card_edition_table;
+static CachedAliasTable shop_item_table;
+static CachedAliasTable booster_pack_table;
+
+bool is_same_roll_context(const RollContext *a, const RollContext *b) {
+  return a->ante == b->ante && a->vouchers == b->vouchers && a->deck_type == b->deck_type &&
+         a->defeated_boss_blinds == b->defeated_boss_blinds && a->unlocked_planets == b->unlocked_planets &&
+         a->most_played_planet == b->most_played_planet &&
+         memcmp(a->owned_jokers, b->owned_jokers, JOKER_ID_WORDS * sizeof(uint32_t)) == 0;
+}
+
+uint8_t get_tag_min_ante(Tag tag) {
+  switch (tag) {
+    case TAG_NEGATIVE:
+    case TAG_STANDARD:
+    case TAG_METEOR:
+    case TAG_BUFFOON:
+    case TAG_HANDY:
+    case TAG_GARBAGE:
+    case TAG_ETHEREAL:
+    case TAG_TOPUP:
+    case TAG_ORBITAL:
+      return 2;
+
+    default:
+      return 1;
+  }
+}
+
+uint8_t get_blind_min_ante(BlindType blind) {
+  switch (blind) {
+    case BLIND_SMALL:
+    case BLIND_BIG:
+    case BLIND_HOOK:
+    case BLIND_CLUB:
+    case BLIND_PSYCHIC:
+    case BLIND_GOAD:
+    case BLIND_WINDOW:
+    case BLIND_MANACLE:
+    case BLIND_PILLAR:
+    case BLIND_HEAD:
+      return 1;
+
+    case BLIND_HOUSE:
+    case BLIND_WALL:
+    case BLIND_WHEEL:
+    case BLIND_ARM:
+    case BLIND_FISH:
+    case BLIND_WATER:
+    case BLIND_MOUTH:
+    case BLIND_NEEDLE:
+    case BLIND_FLINT:
+    case BLIND_MARK:
+      return 2;
+
+    case BLIND_EYE:
+    case BLIND_TOOTH:
+      return 3;
+
+    case BLIND_PLANT:
+      return 4;
+
+    case BLIND_SERPENT:
+      return 5;
+
+    case BLIND_OX:
+      return 6;
+
+    case BLIND_AMBER_ACORN:
+    case BLIND_VERDANT_LEAF:
+    case BLIND_VIOLET_VESSEL:
+    case BLIND_CRIMSON_HEART:
+    case BLIND_CERULEAN_BELL:
+      return 8;
+  }
+}
+
+uint8_t get_booster_pack_items_count(BoosterPackItem *booster_pack) {
+  uint8_t count = booster_pack->size == BOOSTER_PACK_NORMAL ? 3 : 5;
+  if (booster_pack->type == BOOSTER_PACK_BUFFOON) count--;
+  return count;
+}
+
+void offer_item(OfferedItems *offered, ShopItem *item) {
+  uint32_t *items = NULL;
+  uint8_t index = 0;
+
+  switch (item->type) {
+    case SHOP_ITEM_TAROT:
+      items = &offered->tarots;
+      index = item->tarot;
+      break;
+    case SHOP_ITEM_PLANET:
+      items = &offered->planets;
+      index = item->planet;
+      break;
+    case SHOP_ITEM_SPECTRAL:
+      items = &offered->spectrals;
+      index = item->spectral;
+      break;
+    default:
+      return;
+  }
+
+  // Failed roll leaves index out of range
+  if (index < 32) *items |= 1u << index;
+}
+
+// Tarots and spectrals except for The Soul and Black Hole, which are rolled separately
+static uint32_t get_available_tarots(OfferedItems *offered) {
+  return ((1u << (TAROT_WORLD + 1)) - 1) & ~offered->tarots;
+}
+static uint32_t get_available_planets(const RollContext *context, OfferedItems *offered) {
+  return context->unlocked_planets & ~offered->planets;
+}
+static uint32_t get_available_spectrals(OfferedItems *offered) {
+  return ((1u << SPECTRAL_SOUL) - 1) & ~offered->spectrals;
+}
+
+// Editions have their own stream, so new item types or changed weights don't shift them
+static Edition pick_edition(const AliasTable *table) {
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_EDITION);
+  Edition edition = random_alias(table);
+  set_random_subsystem(previous_subsystem);
+
+  return edition;
+}
+
+static int16_t pick_range(uint8_t start, uint64_t candidates) {
+  int16_t index = random_mask_pick(candidates);
+  return index < 0 ? -1 : start + index;
+}
+
+Tag pick_tag(const RollContext *context) {
+  uint8_t ante = context->ante <= 0 ? 1 : context->ante;
+
+  uint64_t candidates = 0;
+  for (Tag tag = TAG_UNCOMMON; tag <= TAG_ECONOMY; tag++)
+    if (ante >= get_tag_min_ante(tag)) candidates |= 1ull << tag;
+
+  return pick_range(TAG_UNCOMMON, candidates);
+}
+
+BlindType pick_boss_blind(const RollContext *context) {
+  uint8_t ante = context->ante <= 0 ? 1 : context->ante;
+  bool is_finisher = context->ante > 0 && context->ante % 8 == 0;
+  BlindType first = is_finisher ? BLIND_AMBER_ACORN : BLIND_HOOK;
+  BlindType last = is_finisher ? BLIND_CERULEAN_BELL : BLIND_MARK;
+
+  uint64_t candidates = 0;
+  for (BlindType blind = first; blind <= last; blind++) {
+    if (context->defeated_boss_blinds & 1 << blind) continue;
+    if (is_finisher || ante >= get_blind_min_ante(blind)) candidates |= 1ull << (blind - first);
+  }
+
+  return pick_range(first, candidates);
+}
+
+static bool is_owned(const RollContext *context, JokerId id) {
+  return context->owned_jokers[id / 32] & (1u << (id % 32));
+}
+
+static ShopItem pick_weighted_joker(const RollContext *context, JokerDistribution *distribution,
+                                    uint16_t rarity_weights[4]) {
+  if (!distribution->is_built ||
+      memcmp(context->owned_jokers, distribution->owned_jokers, sizeof(distribution->owned_jokers))) {
+    memcpy(distribution->owned_jokers, context->owned_jokers, sizeof(distribution->owned_jokers));
+    distribution->is_built = true;
+
+    // Id 0 is never used, so its weight stays 0
+    uint16_t weights[JOKER_ID_COUNT] = {0};
+    bool has_any_weights = false;
+
+    for (JokerId id = JOKER_JOKER; id < JOKER_ID_COUNT; id++) {
+      if (is_owned(context, id)) continue;
+
+      weights[id] = rarity_weights[JOKER_INFO[id].rarity];
+      has_any_weights = true;
+    }
+
+    // TODO According to Wiki "Joker" is returned when there are no more Jokers available and this should be changed
+    // when more jokers will be added
+    // Allow duplicates if there are no more jokers available
+    if (!has_any_weights)
+      for (JokerId id = JOKER_JOKER; id < JOKER_ID_COUNT; id++) weights[id] = rarity_weights[JOKER_INFO[id].rarity];
+
+    build_alias_table(&distribution->table, weights, JOKER_ID_COUNT);
+  }
+
+  ShopItem item = {.type = SHOP_ITEM_JOKER};
+  item.joker.id = random_alias(&distribution->table);
+
+  if (update_alias_table_key(&joker_edition_table, context->vouchers & (VOUCHER_HONE | VOUCHER_GLOW_UP))) {
+    // Base, Foil, Holographic, Polychrome, Negative
+    uint16_t edition_weights[5] = {960, 20, 14, 3, 3};
+    for (uint8_t i = 1; i < 4; i++) {
+      uint8_t multiplier = 1;
+      if (context->vouchers & VOUCHER_GLOW_UP)
+        multiplier = i == 3 ? 7 : 4;
+      else if (context->vouchers & VOUCHER_HONE)
+        multiplier = i == 3 ? 3 : 2;
+
+      edition_weights[0] -= (multiplier - 1) * edition_weights[i];
+      edition_weights[i] *= multiplier;
+    }
+    build_alias_table(&joker_edition_table.table, edition_weights, 5);
+  }
+  item.joker.edition = pick_edition(&joker_edition_table.table);
+
+  return item;
+}
+
+ShopItem pick_joker(const RollContext *context) {
+  // Common, Uncommon, Rare, Legendary
+  uint16_t rarity_weights[] = {70, 25, 5, 0};
+  return pick_weighted_joker(context, &joker_distributions[RARITY_LEGENDARY + 1], rarity_weights);
+}
+
+ShopItem pick_joker_by_rarity(const RollContext *context, Rarity rarity) {
+  // Common, Uncommon, Rare, Legendary
+  uint16_t base_rarity_weights[] = {70, 25, 5, 0};
+  uint16_t rarity_weights[4] = {0};
+  rarity_weights[rarity] = base_rarity_weights[rarity];
+  return pick_weighted_joker(context, &joker_distributions[rarity], rarity_weights);
+}
+
+// Suit is drawn before rank, so order of draws doesn't depend on how compiler evaluates arguments
+static void pick_card_face(Card *card) {
+  card->suit = random_max_value(3);
+  card->rank = random_max_value(12);
+}
+
+static ShopItem pick_card(const RollContext *context) {
+  if (update_alias_table_key(&card_edition_table, context->vouchers & (VOUCHER_HONE | VOUCHER_GLOW_UP))) {
+    uint16_t edition_weights[5] = {920, 12, 28, 40, 0};
+    for (uint8_t i = 1; i < 4; i++) {
+      uint8_t multiplier = (context->vouchers & VOUCHER_GLOW_UP) ? 4 : (context->vouchers & VOUCHER_HONE) ? 2 : 1;
+      edition_weights[0] -= (multiplier - 1) * edition_weights[i];
+      edition_weights[i] *= multiplier;
+    }
+    build_alias_table(&card_edition_table.table, edition_weights, 5);
+  }
+
+  ShopItem item = {.type = SHOP_ITEM_CARD};
+  item.card.edition = pick_edition(&card_edition_table.table);
+  if (random_chance(4, 10)) item.card.enhancement = random_in_range(ENHANCEMENT_BONUS, ENHANCEMENT_LUCKY);
+  if (random_chance(2, 10)) item.card.seal = random_in_range(SEAL_GOLD, SEAL_PURPLE);
+  pick_card_face(&item.card);
+
+  return item;
+}
+
+static ShopItem pick_shop_card(const RollContext *context) {
+  if (!(context->vouchers & VOUCHER_ILLUSION)) {
+    ShopItem item = {.type = SHOP_ITEM_CARD};
+    pick_card_face(&item.card);
+    return item;
+  }
+
+  ShopItem item = pick_card(context);
+  item.card.edition = EDITION_BASE;
+
+  RandomSubsystem previous_subsystem = set_random_subsystem(RANDOM_SUBSYSTEM_EDITION);
+  if (random_chance(2, 10)) item.card.edition = random_in_range(EDITION_FOIL, EDITION_POLYCHROME);
+  set_random_subsystem(previous_subsystem);
+
+  return item;
+}
+
+ShopItem pick_shop_item(const RollContext *context, OfferedItems *offered) {
+  // Only vouchers bought in this run and deck affect item types, so table is kept between rerolls
+  uint32_t shop_vouchers = VOUCHER_MAGIC_TRICK | VOUCHER_TAROT_MERCHANT | VOUCHER_TAROT_TYCOON |
+                           VOUCHER_PLANET_MERCHANT | VOUCHER_PLANET_TYCOON;
+  uint32_t shop_item_key = (context->vouchers & shop_vouchers) | (context->deck_type == DECK_GHOST);
+  if (update_alias_table_key(&shop_item_table, shop_item_key)) {
+    // Card, Tarot, Planet, Joker, Spectral
+    uint16_t shop_item_weights[5] = {0, 40, 40, 200, 0};
+
+    if (context->vouchers & VOUCHER_MAGIC_TRICK) shop_item_weights[0] = 40;
+
+    if (context->vouchers & VOUCHER_TAROT_TYCOON)
+      shop_item_weights[1] = 320;
+    else if (context->vouchers & VOUCHER_TAROT_MERCHANT)
+      shop_item_weights[1] = 96;
+
+    if (context->vouchers & VOUCHER_PLANET_TYCOON)
+      shop_item_weights[2] = 320;
+    else if (context->vouchers & VOUCHER_PLANET_MERCHANT)
+      shop_item_weights[2] = 96;
+
+    if (context->deck_type == DECK_GHOST) shop_item_weights[4] = 20;
+
+    build_alias_table(&shop_item_table.table, shop_item_weights, 5);
+  }
+
+  ShopItemType type = random_alias(&shop_item_table.table);
+  ShopItem item = {.type = type};
+
+  switch (type) {
+    case SHOP_ITEM_CARD:
+      item = pick_shop_card(context);
+      break;
+    case SHOP_ITEM_TAROT:
+      item.tarot = random_mask_pick(get_available_tarots(offered));
+      break;
+    case SHOP_ITEM_PLANET:
+      item.planet = random_mask_pick(get_available_planets(context, offered));
+      break;
+    case SHOP_ITEM_JOKER:
+      item = pick_joker(context);
+      break;
+    case SHOP_ITEM_SPECTRAL:
+      item.spectral = random_mask_pick(get_available_spectrals(offered));
+      break;
+  }
+
+  return item;
+}
+
+BoosterPackItem pick_booster_pack() {
+  if (update_alias_table_key(&booster_pack_table, 0)) {
+    // Standard, Arcana, Celestial, Buffoon, Spectral
+    // Normal, Jumbo, Mega
+    // Standard Normal, Standard Jumbo, Standard Mega, Arcana Normal,...
+    uint16_t booster_pack_weights[5 * 3] = {400, 200, 50, 400, 200, 50, 400, 200, 50, 120, 60, 15, 60, 30, 7};
+    build_alias_table(&booster_pack_table.table, booster_pack_weights, 15);
+  }
+
+  uint8_t random_value = random_alias(&booster_pack_table.table);
+  return (BoosterPackItem){.type = random_value / 3, .size = random_value % 3};
+}
+
+ShopItem pick_booster_pack_item(const RollContext *context, BoosterPackType type, uint8_t index,
+                                OfferedItems *offered) {
+  ShopItem item = {0};
+
+  switch (type) {
+    case BOOSTER_PACK_STANDARD:
+      item = pick_card(context);
+      break;
+    case BOOSTER_PACK_BUFFOON:
+      item = pick_joker(context);
+      break;
+    case BOOSTER_PACK_CELESTIAL:
+      item.type = SHOP_ITEM_PLANET;
+      if (context->vouchers & VOUCHER_TELESCOPE && index == 0)
+        item.planet = context->most_played_planet;
+      else
+        item.planet = random_mask_pick(get_available_planets(context, offered));
+      break;
+    case BOOSTER_PACK_ARCANA:
+      item = (ShopItem){.type = SHOP_ITEM_TAROT, .tarot = random_mask_pick(get_available_tarots(offered))};
+
+      if (context->vouchers & VOUCHER_OMEN_GLOBE && random_percent(0.2))
+        item = (ShopItem){.type = SHOP_ITEM_SPECTRAL, .spectral = random_mask_pick(get_available_spectrals(offered))};
+      break;
+    case BOOSTER_PACK_SPECTRAL:
+      item = (ShopItem){.type = SHOP_ITEM_SPECTRAL, .spectral = random_mask_pick(get_available_spectrals(offered))};
+      break;
+  }
+
+  if ((item.type == SHOP_ITEM_SPECTRAL || item.type == SHOP_ITEM_TAROT) && random_percent(0.03))
+    item = (ShopItem){.type = SHOP_ITEM_SPECTRAL, .spectral = SPECTRAL_SOUL};
+  else if ((item.type == SHOP_ITEM_SPECTRAL || item.type == SHOP_ITEM_PLANET) && random_percent(0.03))
+    item = (ShopItem){.type = SHOP_ITEM_SPECTRAL, .spectral = SPECTRAL_BLACK_HOLE};
+
+  return item;
+}
+
+Voucher pick_voucher(const RollContext *context, uint32_t excluded_vouchers) {
+  // Upgraded voucher is 16 bits above its base one and needs it to be bought first
+  uint32_t vouchers = ~context->vouchers & (0xFFFF | context->vouchers << 16) & ~excluded_vouchers;
+  return 1u << random_mask_pick(vouchers);
+}
@@ -0,0 +1,41 @@
+#ifndef ROLL_H
+#define ROLL_H
+
+#include <stdint.h>
+
+#include "game.h"
+
+// Rolls of tags, boss blinds and shop content depend only on RNG and on these few facts about the run, so they
+// don't touch global state and can be evaluated outside of the game too (see tools/seedscan.c)
+typedef struct {
+  uint8_t ante;
+  uint32_t vouchers;
+  Deck deck_type;
+  uint32_t defeated_boss_blinds;
+  // JOKER_ID_WORDS words with bit for each owned joker id
+  const uint32_t *owned_jokers;
+  uint32_t unlocked_planets;
+  // Planet of the most played poker hand, given first in Celestial Packs with Telescope
+  Planet most_played_planet;
+} RollContext;
+
+bool is_same_roll_context(const RollContext *a, const RollContext *b);
+
+uint8_t get_tag_min_ante(Tag tag);
+uint8_t get_blind_min_ante(BlindType blind);
+
+uint8_t get_booster_pack_items_count(BoosterPackItem *booster_pack);
+void offer_item(OfferedItems *offered, ShopItem *item);
+
+Tag pick_tag(const RollContext *context);
+BlindType pick_boss_blind(const RollContext *context);
+// Picked items have only rolled fields set, jokers need create_joker and cards create_card before they are used
+ShopItem pick_joker(const RollContext *context);
+ShopItem pick_joker_by_rarity(const RollContext *context, Rarity rarity);
+ShopItem pick_shop_item(const RollContext *context, OfferedItems *offered);
+BoosterPackItem pick_booster_pack();
+ShopItem pick_booster_pack_item(const RollContext *context, BoosterPackType type, uint8_t index,
+                                OfferedItems *offered);
+Voucher pick_voucher(const RollContext *context, uint32_t excluded_vouchers);
+
+#endif
@@ -0,0 +1,296 @@
+#include "save.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "debug.h"
+#include "game.h"
+#include "jobs.h"
+#include "random.h"
+#include "state.h"
+
+#include <stdio.h>
+
+#ifdef __PSP__
+#include <pspiofilemgr.h>
+#endif
+
+#define FNV_OFFSET_BASIS (2166136261u)
+#define FNV_PRIME (16777619u)
+
+static const char *SLOT_FILENAMES[SAVE_SLOT_COUNT] = {"save_a.bin", "save_b.bin"};
+
+// Empty until save_init, so runs played without it (e.g. in host tests) are never saved
+static char slot_paths[SAVE_SLOT_COUNT][SAVE_PATH_SIZE];
+static bool is_initialized = false;
+
+typedef struct {
+  SaveHeader header;
+  uint8_t data[SAVE_MAX_SIZE];
+  uint16_t size;
+  bool has_overflowed;
+
+  // Set by main thread on submit and cleared by completion, worker touches only header and data
+  bool is_pending;
+  bool is_written;
+} SaveBuffer;
+
+// Next save is serialized into the other buffer while the previous one is still being written
+static SaveBuffer buffers[2];
+// Slot of a save is its sequence modulo slot count
+static uint32_t next_sequence = 0;
+
+static uint32_t get_checksum(const uint8_t *data, uint16_t size) {
+  uint32_t hash = FNV_OFFSET_BASIS;
+  for (uint16_t i = 0; i < size; i++) hash = (hash ^ data[i]) * FNV_PRIME;
+  return hash;
+}
+
+static void write_bytes(SaveBuffer *buffer, const void *data, size_t size) {
+  if (buffer->has_overflowed || buffer->size + size > SAVE_MAX_SIZE) {
+    buffer->has_overflowed = true;
+    return;
+  }
+
+  memcpy(&buffer->data[buffer->size], data, size);
+  buffer->size += size;
+}
+
+static void write_u8(SaveBuffer *buffer, uint8_t value) { write_bytes(buffer, &value, sizeof(value)); }
+static void write_u16(SaveBuffer *buffer, uint16_t value) { write_bytes(buffer, &value, sizeof(value)); }
+static void write_u32(SaveBuffer *buffer, uint32_t value) { write_bytes(buffer, &value, sizeof(value)); }
+static void write_u64(SaveBuffer *buffer, uint64_t value) { write_bytes(buffer, &value, sizeof(value)); }
+
+static void write_card(SaveBuffer *buffer, Card *card) {
+  write_u16(buffer, card->id);
+  write_u8(buffer, card->suit);
+  write_u8(buffer, card->rank);
+  write_u8(buffer, card->edition);
+  write_u8(buffer, card->enhancement);
+  write_u8(buffer, card->seal);
+  write_u16(buffer, card->chips);
+}
+
+static void write_joker(SaveBuffer *buffer, Joker *joker) {
+  write_u8(buffer, joker->id);
+  write_u8(buffer, joker->edition);
+  write_bytes(buffer, &joker->scaling, sizeof(joker->scaling));
+}
+
+static void write_consumable(SaveBuffer *buffer, Consumable *consumable) {
+  write_u8(buffer, consumable->type);
+  write_u8(buffer, consumable->planet);
+}
+
+static void write_shop_item(SaveBuffer *buffer, ShopItem *item) {
+  write_u8(buffer, item->type);
+  write_u8(buffer, item->is_free);
+
+  switch (item->type) {
+    case SHOP_ITEM_CARD:
+      write_card(buffer, &item->card);
+      break;
+    case SHOP_ITEM_JOKER:
+      write_joker(buffer, &item->joker);
+      break;
+    case SHOP_ITEM_TAROT:
+    case SHOP_ITEM_PLANET:
+    case SHOP_ITEM_SPECTRAL:
+      write_u8(buffer, item->planet);
+      break;
+  }
+}
+
+// Saves are made only between blinds, so state that lives only within a blind is not stored
+static void serialize_run(SaveBuffer *buffer) {
+  Game *game = &state.game;
+
+  write_u8(buffer, state.stage);
+  write_u32(buffer, game->seed);
+  write_u8(buffer, game->deck_type);
+  write_u8(buffer, game->stake);
+  for (RandomSubsystem subsystem = 0; subsystem < RANDOM_SUBSYSTEM_COUNT; subsystem++)
+    write_u64(buffer, get_random_position(subsystem));
+
+  write_u8(buffer, game->ante);
+  write_u8(buffer, game->round);
+  write_u16(buffer, game->money);
+  write_u32(buffer, game->vouchers);
+  write_u32(buffer, game->defeated_boss_blinds);
+  write_u8(buffer, game->has_rerolled_boss);
+
+  write_u8(buffer, game->hand.size);
+  write_u8(buffer, game->hands.total);
+  write_u8(buffer, game->discards.total);
+  write_u8(buffer, game->jokers.size);
+  write_u8(buffer, game->consumables.size);
+  write_u8(buffer, game->shop.size);
+
+  write_u8(buffer, game->current_blind - game->blinds);
+  for (uint8_t i = 0; i < 3; i++) {
+    write_u8(buffer, game->blinds[i].type);
+    write_u8(buffer, game->blinds[i].is_active);
+    write_u8(buffer, game->blinds[i].tag);
+  }
+
+  for (uint8_t i = 0; i < 12; i++) {
+    write_u8(buffer, game->poker_hands[i].level);
+    write_u16(buffer, game->poker_hands[i].played);
+  }
+
+  write_u8(buffer, cvector_size(game->tags));
+  cvector_for_each(game->tags, Tag, tag) write_u8(buffer, *tag);
+
+  write_u8(buffer, game->fool_last_used.was_used);
+  write_consumable(buffer, &game->fool_last_used.consumable);
+
+  write_u16(buffer, cvector_size(game->full_deck));
+  cvector_for_each(game->full_deck, Card, card) write_card(buffer, card);
+
+  write_u8(buffer, cvector_size(game->jokers.cards));
+  cvector_for_each(game->jokers.cards, Joker, joker) write_joker(buffer, joker);
+
+  write_u8(buffer, cvector_size(game->consumables.items));
+  cvector_for_each(game->consumables.items, Consumable, consumable) write_consumable(buffer, consumable);
+
+  write_u8(buffer, game->shop.reroll_count);
+  write_u8(buffer, cvector_size(game->shop.vouchers));
+  cvector_for_each(game->shop.vouchers, Voucher, voucher) write_u32(buffer, *voucher);
+  write_u8(buffer, cvector_size(game->shop.items));
+  cvector_for_each(game->shop.items, ShopItem, item) write_shop_item(buffer, item);
+  write_u8(buffer, cvector_size(game->shop.booster_packs));
+  cvector_for_each(game->shop.booster_packs, BoosterPackItem, pack) {
+    write_u8(buffer, pack->type);
+    write_u8(buffer, pack->size);
+    write_u8(buffer, pack->is_free);
+  }
+}
+
+// Header is written first, so a write interrupted anywhere leaves data that doesn't match its checksum
+#ifdef __PSP__
+static bool write_slot(const char *filename, SaveHeader *header, uint8_t *data) {
+  SceUID file = sceIoOpen(filename, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
+  if (file < 0) return false;
+
+  bool is_written = sceIoWrite(file, header, sizeof(SaveHeader)) == (int)sizeof(SaveHeader) &&
+                    sceIoWrite(file, data, header->size) == header->size;
+  return sceIoClose(file) >= 0 && is_written;
+}
+
+static bool read_slot(const char *filename, SaveHeader *header, uint8_t *data) {
+  SceUID file = sceIoOpen(filename, PSP_O_RDONLY, 0);
+  if (file < 0) return false;
+
+  bool is_read = sceIoRead(file, header, sizeof(SaveHeader)) == (int)sizeof(SaveHeader) &&
+                 header->size <= SAVE_MAX_SIZE && sceIoRead(file, data, header->size) == header->size;
+  sceIoClose(file);
+  return is_read;
+}
+#else
+static bool write_slot(const char *filename, SaveHeader *header, uint8_t *data) {
+  FILE *file = fopen(filename, "wb");
+  if (file == NULL) return false;
+
+  bool is_written = fwrite(header, sizeof(SaveHeader), 1, file) == 1 &&
+                    (header->size == 0 || fwrite(data, header->size, 1, file) == 1);
+  return fclose(file) == 0 && is_written;
+}
+
+static bool read_slot(const char *filename, SaveHeader *header, uint8_t *data) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL) return false;
+
+  bool is_read = fread(header, sizeof(SaveHeader), 1, file) == 1 && header->size <= SAVE_MAX_SIZE &&
+                 (header->size == 0 || fread(data, header->size, 1, file) == 1);
+  fclose(file);
+  return is_read;
+}
+#endif
+
+static bool is_valid_slot(const char *filename, SaveHeader *header, uint8_t *data) {
+  return read_slot(filename, header, data) && header->magic == SAVE_MAGIC && header->version == SAVE_VERSION &&
+         header->checksum == get_checksum(data, header->size);
+}
+
+void save_init(const char *directory) {
+  is_initialized = false;
+  for (uint8_t slot = 0; slot < SAVE_SLOT_COUNT; slot++) {
+    int length = snprintf(slot_paths[slot], SAVE_PATH_SIZE, "%s%s", directory, SLOT_FILENAMES[slot]);
+    if (length < 0 || length >= SAVE_PATH_SIZE) {
+      log_message(LOG_ERROR, "Save directory %s is too long, runs won't be saved.", directory);
+      return;
+    }
+  }
+
+  bool has_latest = false;
+  uint32_t latest_sequence = 0;
+
+  // Nothing is being saved yet, so first buffer can hold data that is read
+  for (uint8_t slot = 0; slot < SAVE_SLOT_COUNT; slot++) {
+    SaveHeader header;
+    if (!is_valid_slot(slot_paths[slot], &header, buffers[0].data)) continue;
+    // Sequence decides the slot, file which doesn't match it was copied there by hand
+    if (header.sequence % SAVE_SLOT_COUNT != slot) continue;
+
+    if (!has_latest || header.sequence > latest_sequence) latest_sequence = header.sequence;
+    has_latest = true;
+  }
+
+  next_sequence = has_latest ? latest_sequence + 1 : 0;
+  is_initialized = true;
+  if (has_latest)
+    log_message(LOG_INFO, "Latest save is %s (sequence %u).", slot_paths[latest_sequence % SAVE_SLOT_COUNT],
+                latest_sequence);
+}
+
+static void write_save(void *data) {
+  SaveBuffer *buffer = data;
+  buffer->is_written = write_slot(slot_paths[buffer->header.sequence % SAVE_SLOT_COUNT], &buffer->header, buffer->data);
+}
+
+static void complete_save(void *data) {
+  SaveBuffer *buffer = data;
+  buffer->is_pending = false;
+
+  if (buffer->is_written) return;
+
+  log_message(LOG_ERROR, "Failed to write %s.", slot_paths[buffer->header.sequence % SAVE_SLOT_COUNT]);
+  // Failed slot is written again by the next save, so the other one keeps the last good save until then
+  if (next_sequence == buffer->header.sequence + 1) next_sequence--;
+}
+
+void save_game() {
+  if (!is_initialized) return;
+
+  SaveBuffer *buffer = NULL;
+  for (uint8_t i = 0; i < 2 && buffer == NULL; i++)
+    if (!buffers[i].is_pending) buffer = &buffers[i];
+
+  if (buffer == NULL) {
+    log_message(LOG_WARNING, "Previous saves are still being written, run was not saved.");
+    return;
+  }
+
+  buffer->size = 0;
+  buffer->has_overflowed = false;
+  serialize_run(buffer);
+
+  if (buffer->has_overflowed) {
+    log_message(LOG_ERROR, "Run doesn't fit into %d bytes, it was not saved.", SAVE_MAX_SIZE);
+    return;
+  }
+
+  buffer->header = (SaveHeader){.magic = SAVE_MAGIC,
+                                .version = SAVE_VERSION,
+                                .size = buffer->size,
+                                .sequence = next_sequence++,
+                                .checksum = get_checksum(buffer->data, buffer->size)};
+  buffer->is_pending = true;
+
+  Job job = {.run = write_save, .complete = complete_save, .data = buffer};
+  if (job_submit(JOB_PRIORITY_NORMAL, job)) return;
+
+  write_save(buffer);
+  complete_save(buffer);
+}
@@ -0,0 +1,31 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+#include <stdint.h>
+
+#define SAVE_MAGIC (0x5653504A)
+#define SAVE_VERSION (1)
+#define SAVE_MAX_SIZE (8192)
+#define SAVE_PATH_SIZE (128)
+
+// Saves alternate between two slots, so crash while writing one of them always leaves the other one intact.
+// Slot with valid checksum and higher sequence is the latest one.
+#define SAVE_SLOT_COUNT (2)
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  // Size of data following the header
+  uint16_t size;
+  uint32_t sequence;
+  // FNV-1a of data
+  uint32_t checksum;
+} SaveHeader;
+
+// Slots are kept in directory, which is empty or ends with a separator. Finds the latest valid slot there, so the
+// next save goes to the other one.
+void save_init(const char *directory);
+// Run is serialized right away and written to memory stick on job thread, nothing is saved before save_init
+void save_game();
+
+#endif
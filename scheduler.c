@@ -0,0 +1,76 @@
+#include "scheduler.h"
+
+#include "compositor.h"
+#include "state.h"
+
+static uint8_t get_pacing_rate(FramePacing pacing) {
+  switch (pacing) {
+    case FRAME_PACING_60_HZ:
+      return 60;
+    case FRAME_PACING_30_HZ:
+      return 30;
+    case FRAME_PACING_20_HZ:
+      return 20;
+    case FRAME_PACING_EVENT_DRIVEN:
+      return 0;
+
+    case FRAME_PACING_ADAPTIVE:
+      break;
+  }
+
+  // Nothing animates on these screens apart from the background
+  if (state.stage == STAGE_CREDITS || state.stage == STAGE_GAME_OVER || state.overlay != OVERLAY_NONE) return 0;
+
+  float idle_time = state.scheduler.idle_time;
+  if (idle_time < SCHEDULER_ACTIVE_PERIOD) return 60;
+  if (idle_time < SCHEDULER_IDLE_PERIOD) return 30;
+  if (idle_time < SCHEDULER_SLEEP_PERIOD) return 20;
+  return 0;
+}
+
+static void apply_rate(uint8_t rate) {
+  state.scheduler.rate = rate;
+  compositor_set_animation_interval(rate > 0 ? DISPLAY_REFRESH_RATE / rate : 0);
+}
+
+void scheduler_init(FramePacing pacing) {
+  state.scheduler = (FrameScheduler){0};
+  scheduler_set_pacing(pacing);
+}
+
+void scheduler_set_pacing(FramePacing pacing) {
+  state.scheduler.pacing = pacing;
+  apply_rate(get_pacing_rate(pacing));
+}
+
+void scheduler_notify_input() { state.scheduler.has_input = 1; }
+
+void scheduler_update(uint64_t time) {
+  FrameScheduler *scheduler = &state.scheduler;
+  scheduler->frame_start = time;
+
+  // Idle time stays at 0 for the whole iteration in which input has arrived
+  scheduler->idle_time = scheduler->has_input ? 0 : scheduler->idle_time + state.delta;
+  scheduler->has_input = 0;
+  apply_rate(get_pacing_rate(scheduler->pacing));
+
+  scheduler->has_new_stats = 0;
+  scheduler->stats_time += state.delta;
+  if (scheduler->stats_time < SCHEDULER_STATS_PERIOD) return;
+
+  FrameBusyTime *busy = &scheduler->busy;
+  scheduler->cpu_time = busy->frames > 0 ? busy->cpu / 1000.0f / busy->frames : 0;
+  scheduler->gpu_time = busy->frames > 0 ? busy->gpu / 1000.0f / busy->frames : 0;
+  scheduler->frame_rate = busy->frames / scheduler->stats_time + 0.5f;
+  scheduler->has_new_stats = 1;
+
+  *busy = (FrameBusyTime){0};
+  scheduler->stats_time = 0;
+}
+
+void scheduler_record_frame(uint64_t finish_time) {
+  state.scheduler.busy.cpu += finish_time - state.scheduler.frame_start;
+  state.scheduler.busy.frames++;
+}
+
+void scheduler_record_gpu_time(uint64_t gpu_time) { state.scheduler.busy.gpu += gpu_time; }
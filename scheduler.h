@@ -0,0 +1,64 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+#define DISPLAY_REFRESH_RATE (60)
+
+// Adaptive pacing keeps full rate for this many seconds after the last input, then drops to 30 Hz
+#define SCHEDULER_ACTIVE_PERIOD (5.0f)
+// Then 20 Hz until this many seconds of inactivity
+#define SCHEDULER_IDLE_PERIOD (20.0f)
+// Then animations stop and frames are drawn only in response to input
+#define SCHEDULER_SLEEP_PERIOD (60.0f)
+
+// Busy times are averaged over this many seconds before they are shown
+#define SCHEDULER_STATS_PERIOD (1.0f)
+
+#ifndef DEFAULT_FRAME_PACING
+#define DEFAULT_FRAME_PACING FRAME_PACING_ADAPTIVE
+#endif
+
+typedef enum {
+  // Rate is lowered the longer there is no input, static screens are event-driven
+  FRAME_PACING_ADAPTIVE,
+  FRAME_PACING_60_HZ,
+  FRAME_PACING_30_HZ,
+  FRAME_PACING_20_HZ,
+  // Animations are stopped, frames are drawn only when layout changes
+  FRAME_PACING_EVENT_DRIVEN,
+} FramePacing;
+
+typedef struct {
+  uint64_t cpu;
+  uint64_t gpu;
+  uint32_t frames;
+} FrameBusyTime;
+
+typedef struct {
+  FramePacing pacing;
+  // Current animation rate, 0 when event-driven
+  uint8_t rate;
+  float idle_time;
+  uint8_t has_input;
+
+  uint64_t frame_start;
+  float stats_time;
+  FrameBusyTime busy;
+  // Averages per drawn frame of the last finished period in milliseconds
+  float cpu_time;
+  float gpu_time;
+  uint8_t frame_rate;
+  uint8_t has_new_stats;
+} FrameScheduler;
+
+void scheduler_init(FramePacing pacing);
+void scheduler_set_pacing(FramePacing pacing);
+void scheduler_notify_input();
+
+// Called once per vblank, before compositor decides whether frame has to be drawn
+void scheduler_update(uint64_t time);
+void scheduler_record_frame(uint64_t finish_time);
+void scheduler_record_gpu_time(uint64_t gpu_time);
+
+#endif
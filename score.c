@@ -0,0 +1,117 @@
+#include "score.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Plain doubles are kept below this threshold, so sums of two of them never overflow
+#define SCORE_PLAIN_LIMIT 0x1p1000
+#define SCORE_SCIENTIFIC_THRESHOLD 1e11
+
+static BigScore score_normalize(double mantissa, int32_t exponent) {
+  if (mantissa == 0 || !isfinite(mantissa)) return (BigScore){.mantissa = mantissa, .exponent = 0};
+
+  if (exponent == 0 && fabs(mantissa) < SCORE_PLAIN_LIMIT) return (BigScore){.mantissa = mantissa, .exponent = 0};
+
+  int shift;
+  double normalized = frexp(mantissa, &shift);
+  int64_t total = (int64_t)exponent + shift;
+
+  // Fold back into a plain double when the value is small again
+  if (total < 1000) return (BigScore){.mantissa = ldexp(normalized, total), .exponent = 0};
+  if (total > INT32_MAX) total = INT32_MAX;
+
+  return (BigScore){.mantissa = normalized, .exponent = total};
+}
+
+BigScore score_from_double(double value) { return score_normalize(value, 0); }
+
+BigScore score_from_log10(double value) {
+  if (value < 300) return score_normalize(pow(10, value), 0);
+
+  double exponent = value * log2(10.0);
+  double integer_part = floor(exponent);
+  return score_normalize(exp2(exponent - integer_part), integer_part > INT32_MAX ? INT32_MAX : integer_part);
+}
+
+BigScore score_from_product(double a, double b) {
+  double product = a * b;
+  if (isfinite(product)) return score_normalize(product, 0);
+
+  int exponent_a, exponent_b;
+  double mantissa_a = frexp(a, &exponent_a);
+  double mantissa_b = frexp(b, &exponent_b);
+
+  return score_normalize(mantissa_a * mantissa_b, exponent_a + exponent_b);
+}
+
+BigScore score_scale(BigScore score, double factor) {
+  if (score.exponent == 0) return score_from_product(score.mantissa, factor);
+
+  int shift;
+  double mantissa = frexp(factor, &shift);
+  return score_normalize(score.mantissa * mantissa, score.exponent + shift);
+}
+
+BigScore score_add(BigScore a, BigScore b) {
+  if (a.exponent == 0 && b.exponent == 0) return score_normalize(a.mantissa + b.mantissa, 0);
+
+  if (a.mantissa == 0) return b;
+  if (b.mantissa == 0) return a;
+
+  int shift_a, shift_b;
+  double mantissa_a = frexp(a.mantissa, &shift_a);
+  double mantissa_b = frexp(b.mantissa, &shift_b);
+  int64_t exponent_a = (int64_t)a.exponent + shift_a;
+  int64_t exponent_b = (int64_t)b.exponent + shift_b;
+
+  if (exponent_a < exponent_b) {
+    double mantissa_tmp = mantissa_a;
+    mantissa_a = mantissa_b;
+    mantissa_b = mantissa_tmp;
+
+    int64_t exponent_tmp = exponent_a;
+    exponent_a = exponent_b;
+    exponent_b = exponent_tmp;
+  }
+
+  // Smaller operand is below double precision of the bigger one
+  if (exponent_a - exponent_b > 64) return score_normalize(mantissa_a, exponent_a);
+
+  return score_normalize(mantissa_a + ldexp(mantissa_b, exponent_b - exponent_a), exponent_a);
+}
+
+int8_t score_compare(BigScore a, BigScore b) {
+  if (a.exponent == 0 && b.exponent == 0) return (a.mantissa > b.mantissa) - (a.mantissa < b.mantissa);
+
+  // Scores are never negative, so zero is always the smallest value
+  if (a.mantissa == 0 || b.mantissa == 0) return (a.mantissa != 0) - (b.mantissa != 0);
+
+  int shift_a, shift_b;
+  double mantissa_a = frexp(a.mantissa, &shift_a);
+  double mantissa_b = frexp(b.mantissa, &shift_b);
+  int64_t exponent_a = (int64_t)a.exponent + shift_a;
+  int64_t exponent_b = (int64_t)b.exponent + shift_b;
+
+  if (exponent_a != exponent_b) return exponent_a > exponent_b ? 1 : -1;
+  return (mantissa_a > mantissa_b) - (mantissa_a < mantissa_b);
+}
+
+double score_log10(BigScore score) { return log10(score.mantissa) + score.exponent * log10(2.0); }
+
+void score_format(char *buffer, size_t size, BigScore score) {
+  if (score.exponent == 0 && score.mantissa < SCORE_SCIENTIFIC_THRESHOLD) {
+    snprintf(buffer, size, "%.0lf", score.mantissa);
+    return;
+  }
+
+  double exponent = floor(score_log10(score));
+  double mantissa = pow(10, score_log10(score) - exponent);
+
+  // Rounding to 3 decimal places can carry into the next power of ten
+  if (mantissa >= 9.9995) {
+    mantissa /= 10;
+    exponent++;
+  }
+
+  snprintf(buffer, size, "%.3lfe%.0lf", mantissa, exponent);
+}
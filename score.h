@@ -0,0 +1,23 @@
+#ifndef SCORE_H
+#define SCORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Value is mantissa * 2^exponent. Exponent stays 0 while the mantissa fits comfortably in a double,
+// so small scores use plain (exact) double arithmetic and only endless mode pays for normalization.
+typedef struct {
+  double mantissa;
+  int32_t exponent;
+} BigScore;
+
+BigScore score_from_double(double value);
+BigScore score_from_log10(double value);
+BigScore score_from_product(double a, double b);
+BigScore score_scale(BigScore score, double factor);
+BigScore score_add(BigScore a, BigScore b);
+int8_t score_compare(BigScore a, BigScore b);
+double score_log10(BigScore score);
+void score_format(char *buffer, size_t size, BigScore score);
+
+#endif
@@ -1,14 +1,18 @@
 #include "state.h"
 
 #include <clay.h>
-#include <cvector.h>
+#include <malloc.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "debug.h"
 #include "game.h"
 #include "gfx.h"
+#include "random.h"
+#include "vector.h"
 
 const NavigationRow jokers_consumables_row = {2, {NAVIGATION_JOKERS, NAVIGATION_CONSUMABLES}};
 
@@ -48,44 +52,149 @@ static const NavigationLayout overlay_nav_layouts[] = {
     {.row_count = 0},
 };
 
+static FrameArenaChunk *create_frame_arena_chunk(size_t capacity) {
+  FrameArenaChunk *chunk = memalign(16, sizeof(FrameArenaChunk) + capacity);
+  if (chunk == NULL) return NULL;
+
+  chunk->next = NULL;
+  chunk->capacity = capacity;
+  chunk->offset = 0;
+  return chunk;
+}
+
+static void free_frame_arena_chunks() {
+  FrameArenaChunk *chunk = state.frame_arena.first;
+  while (chunk != NULL) {
+    FrameArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  state.frame_arena.first = NULL;
+  state.frame_arena.current = NULL;
+}
+
+void frame_arena_init() {
+  state.frame_arena.first = create_frame_arena_chunk(FRAME_ARENA_CHUNK_CAPACITY);
+  state.frame_arena.current = state.frame_arena.first;
+  memset(state.frame_arena.stats, 0, sizeof(state.frame_arena.stats));
+}
+
+void frame_arena_destroy() { free_frame_arena_chunks(); }
+
+void frame_arena_reset() {
+  size_t capacity = 0;
+  uint8_t chunk_count = 0;
+  for (FrameArenaChunk *chunk = state.frame_arena.first; chunk != NULL; chunk = chunk->next) {
+    chunk->offset = 0;
+    capacity += chunk->capacity;
+    chunk_count++;
+  }
+
+  // Previous layout needed more than one chunk, merge them so next ones fit in a single chunk
+  if (chunk_count > 1) {
+    free_frame_arena_chunks();
+    state.frame_arena.first = create_frame_arena_chunk(capacity);
+    log_message(LOG_INFO, "Frame arena has grown to %zu bytes.", capacity);
+  }
+
+  state.frame_arena.current = state.frame_arena.first;
+}
+
+size_t frame_arena_get_used() {
+  size_t used = 0;
+  for (FrameArenaChunk *chunk = state.frame_arena.first; chunk != NULL; chunk = chunk->next) {
+    used += chunk->offset;
+    if (chunk == state.frame_arena.current) break;
+  }
+
+  return used;
+}
+
+void frame_arena_update_stats() {
+  size_t used = frame_arena_get_used();
+  FrameArenaStats *stats = &state.frame_arena.stats[state.stage];
+
+  if (used > stats->peak) stats->peak = used;
+  stats->total += used;
+  stats->layouts++;
+}
+
+static void *frame_arena_push(size_t size, size_t alignment) {
+  FrameArenaChunk *chunk = state.frame_arena.current;
+  if (chunk == NULL) {
+    chunk = create_frame_arena_chunk(size > FRAME_ARENA_CHUNK_CAPACITY ? size : FRAME_ARENA_CHUNK_CAPACITY);
+    state.frame_arena.first = chunk;
+    state.frame_arena.current = chunk;
+    if (chunk == NULL) {
+      log_message(LOG_ERROR, "Frame arena overflow: Failed to allocate memory.");
+      return NULL;
+    }
+  }
+
+  size_t offset = (chunk->offset + alignment - 1) & ~(alignment - 1);
+  while (offset + size > chunk->capacity) {
+    if (chunk->next == NULL) {
+      chunk->next = create_frame_arena_chunk(size > FRAME_ARENA_CHUNK_CAPACITY ? size : FRAME_ARENA_CHUNK_CAPACITY);
+      if (chunk->next == NULL) {
+        log_message(LOG_ERROR, "Frame arena overflow: Failed to allocate memory.");
+        return NULL;
+      }
+    }
+
+    chunk = chunk->next;
+    offset = 0;
+  }
+
+  state.frame_arena.current = chunk;
+  chunk->offset = offset + size;
+  return &chunk->data[offset];
+}
+
 int append_clay_string(Clay_String *dest, const char *format, ...) {
-  size_t remaining = FRAME_ARENA_CAPACITY - state.frame_arena.offset;
-  char *dst = (char *)state.frame_arena.data + state.frame_arena.offset;
+  FrameArenaChunk *chunk = state.frame_arena.current;
+  size_t remaining = chunk != NULL ? chunk->capacity - chunk->offset : 0;
+  char *dst = chunk != NULL ? (char *)&chunk->data[chunk->offset] : NULL;
 
   va_list args;
   va_start(args, format);
   int written = vsnprintf(dst, remaining, format, args);
   va_end(args);
 
-  if (written < 0 || (size_t)written >= remaining) {
-    log_message(LOG_ERROR, "Frame arena overflow: Failed to append Clay string.");
-    written = (remaining > 0) ? remaining - 1 : 0;
+  if (written < 0) {
+    log_message(LOG_ERROR, "Failed to format Clay string.");
+    written = 0;
+  }
+
+  if ((size_t)written < remaining) {
+    chunk->offset += written;
+  } else {
+    // String does not fit in current chunk, format it again in the next one
+    dst = frame_arena_push(written + 1, 1);
+    if (dst == NULL) {
+      written = 0;
+    } else {
+      va_start(args, format);
+      vsnprintf(dst, written + 1, format, args);
+      va_end(args);
+    }
   }
 
   dest->isStaticallyAllocated = 0;
   dest->chars = dst;
   dest->length = written;
 
-  state.frame_arena.offset += written;
-
   return written;
 }
 
+Clay_String static_clay_string(const char *chars) {
+  // Clay identifies statically allocated strings by pointer, so they are never copied nor rehashed
+  return (Clay_String){.isStaticallyAllocated = 1, .length = strlen(chars), .chars = chars};
+}
+
 void *frame_arena_allocate(size_t size) {
   // Align offset to 16 bytes as it is required by PSP device
-  size_t alignment = 16;
-  size_t padding = (alignment - (state.frame_arena.offset % alignment)) % alignment;
-  state.frame_arena.offset += padding;
-
-  if (state.frame_arena.offset + size > FRAME_ARENA_CAPACITY) {
-    log_message(LOG_ERROR, "Frame arena overflow: Failed to allocate memory.");
-    state.running = 0;
-    return NULL;
-  }
-
-  void *ptr = &state.frame_arena.data[state.frame_arena.offset];
-  state.frame_arena.offset += size;
-  return ptr;
+  return frame_arena_push(size, 16);
 }
 
 uint8_t calc_proportional_hovered(uint8_t current_count, uint8_t next_count) {
@@ -280,7 +389,7 @@ void overlay_menu_button_click() {
       Deck current_deck = state.game.deck_type;
       Stake current_stake = state.game.stake;
       game_destroy();
-      game_init(current_deck, current_stake);
+      game_init(current_deck, current_stake, get_new_run_seed());
       break;
     }
 
@@ -4,10 +4,12 @@
 #include <clay.h>
 #include <pspctrl.h>
 
+#include "compositor.h"
 #include "game.h"
+#include "scheduler.h"
 #include "system.h"
 
-#define FRAME_ARENA_CAPACITY (5120)
+#define FRAME_ARENA_CHUNK_CAPACITY (4096)
 
 #define MAX_NAV_ROWS 3
 #define MAX_NAV_SECTIONS_PER_ROW 2
@@ -30,8 +32,12 @@ typedef enum {
   STAGE_GAME_OVER,
 } Stage;
 
+#define STAGE_COUNT (STAGE_GAME_OVER + 1)
+
 typedef enum { OVERLAY_NONE, OVERLAY_MENU, OVERLAY_SELECT_STAKE, OVERLAY_POKER_HANDS } Overlay;
 
+#define OVERLAY_COUNT (OVERLAY_POKER_HANDS + 1)
+
 typedef enum {
   NAVIGATION_NONE,
   NAVIGATION_MAIN_MENU,
@@ -70,13 +76,36 @@ typedef struct {
   NavigationCursor cursor;
 } Navigation;
 
-typedef struct {
-  uint8_t data[FRAME_ARENA_CAPACITY];
+typedef struct FrameArenaChunk {
+  struct FrameArenaChunk *next;
+  size_t capacity;
   size_t offset;
-} Arena;
+  uint8_t data[] __attribute__((aligned(16)));
+} FrameArenaChunk;
+
+typedef struct {
+  size_t peak;
+  uint64_t total;
+  uint32_t layouts;
+} FrameArenaStats;
+
+// Memory for data referenced by render commands, it lives until the next layout is calculated.
+// Grows by chaining chunks, which are merged into a single one on reset.
+typedef struct {
+  FrameArenaChunk *first;
+  FrameArenaChunk *current;
+  FrameArenaStats stats[STAGE_COUNT];
+} FrameArena;
+
+void frame_arena_init();
+void frame_arena_destroy();
+void frame_arena_reset();
+void frame_arena_update_stats();
+size_t frame_arena_get_used();
 
 void *frame_arena_allocate(size_t size);
 int append_clay_string(Clay_String *dest, const char *format, ...);
+Clay_String static_clay_string(const char *chars);
 
 uint8_t get_nav_section_size(NavigationSection section);
 uint8_t is_nav_section_horizontal(NavigationSection section);
@@ -94,8 +123,10 @@ void main_menu_button_click();
 void select_blind_button_click();
 
 typedef struct {
-  Arena frame_arena;
+  FrameArena frame_arena;
   Clay_RenderCommandArray render_commands;
+  Compositor compositor;
+  FrameScheduler scheduler;
 
   Texture *cards_atlas;
   Texture *jokers_atlas1;
@@ -114,6 +145,10 @@ typedef struct {
 
   float delta;
   float time;
+  // Time used by animation layer, it lags behind when compositor advances animations in steps
+  float animation_time;
+  // Background scrolls in coarser steps than the rest of animation layer
+  float background_time;
   uint8_t running;
 
   Game game;
@@ -4,27 +4,60 @@
 #include <math.h>
 #include <pspctrl.h>
 #include <pspdisplay.h>
+#include <pspge.h>
 #include <pspgu.h>
 #include <pspkernel.h>
 #include <stb_image.h>
 #include <stdlib.h>
 
+#include "compositor.h"
+#include "counters.h"
+#include "debug.h"
 #include "game.h"
 #include "gfx.h"
+#include "jobs.h"
+#include "random.h"
+#include "render_batch.h"
+#include "scheduler.h"
 #include "state.h"
 
-static Vertex vertex_buffer[RENDER_BATCH_SIZE];
 static RenderBatch render_batch = {.count = 0};
 
+// While GPU executes one display list, the next frame is built in the other one.
+// Vertices are allocated from the list too, so each list also works as vertex pool of its frame.
+static char __attribute__((aligned(16))) display_lists[2][DISPLAY_LIST_SIZE];
+static uint8_t current_list = 0;
+static int display_list_peak = 0;
+static PspGeContext ge_context;
+
+static void *frame_buffers[2];
+static uint8_t draw_buffer = 0;
+static Rect frame_region;
+// Buffer with finished frame that has not been shown yet, -1 if there is none
+static int8_t pending_buffer = -1;
+
+static uint64_t gpu_start_time = 0;
+static volatile uint64_t gpu_finish_time = 0;
+
 void draw_rectangle(Rect *rect, uint32_t color) { draw_texture(NULL, &(Rect){0, 0, 0, 0}, rect, color, 0); }
 
 void draw_texture(Texture *texture, Rect *src, Rect *dst, uint32_t color, float angle) {
+  // Still being decoded
+  if (texture != NULL && texture->data == NULL) return;
+
   uint8_t is_angled = (angle != 0);
 
   if (render_batch.texture != texture || render_batch.is_angled != is_angled ||
-      render_batch.count + 6 > RENDER_BATCH_SIZE)
+      render_batch.count + 6 > render_batch.capacity)
     flush_render_batch();
 
+  // Nothing else can be added to display list until batch is flushed, otherwise it would overwrite the vertices
+  if (render_batch.count == 0) reserve_render_batch(&render_batch, display_lists[current_list], sceGuCheckList());
+  if (render_batch.capacity < 6) {
+    log_message(LOG_ERROR, "Display list is full, sprite was not drawn.");
+    return;
+  }
+
   render_batch.texture = texture;
   render_batch.is_angled = is_angled;
 
@@ -71,6 +104,12 @@ void flush_render_batch() {
   if (render_batch.count == 0) return;
   Texture *texture = render_batch.texture;
 
+  // Vertices are already in place, so this only moves list past them. It has to come before any other command.
+  if (!commit_render_batch(&render_batch, sceGuGetMemory(render_batch.count * sizeof(Vertex)))) {
+    log_message(LOG_ERROR, "Display list has grown since render batch was reserved, batch was not drawn.");
+    return;
+  }
+
   if (texture != NULL) {
     sceGuTexMode(GU_PSM_8888, 0, 0, GU_FALSE);
     sceGuTexImage(0, texture->width, texture->height, texture->width, texture->data);
@@ -86,16 +125,12 @@ void flush_render_batch() {
     sceGuEnable(GU_TEXTURE_2D);
   }
 
-  // Copy from RAM buffer to GPU memory
-  Vertex *gpu_vertices = (Vertex *)sceGuGetMemory(render_batch.count * sizeof(Vertex));
-  memcpy(gpu_vertices, render_batch.vertices, render_batch.count * sizeof(Vertex));
-
   sceGuEnable(GU_BLEND);
   sceGuBlendFunc(GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0);
 
   sceGuDrawArray(render_batch.is_angled == 0 ? GU_SPRITES : GU_TRIANGLES,
                  GU_COLOR_8888 | GU_TEXTURE_32BITF | GU_VERTEX_32BITF | GU_TRANSFORM_2D, render_batch.count, 0,
-                 gpu_vertices);
+                 render_batch.vertices);
 
   sceGuDisable(GU_BLEND);
   if (texture != NULL) sceGuDisable(GU_TEXTURE_2D);
@@ -113,6 +148,46 @@ Texture *load_texture(const char *filename) {
   return texture;
 }
 
+typedef struct {
+  const char *filename;
+  Texture *texture;
+  // Decoded separately, so texture stays empty until completion
+  int width, height;
+  uint32_t *data;
+} TextureLoad;
+
+static void decode_texture(void *data) {
+  TextureLoad *load = data;
+  load->data = (uint32_t *)stbi_load(load->filename, &load->width, &load->height, NULL, STBI_rgb_alpha);
+}
+
+static void complete_texture_load(void *data) {
+  TextureLoad *load = data;
+  load->texture->width = load->width;
+  load->texture->height = load->height;
+  load->texture->data = load->data;
+  free(load);
+
+  sceKernelDcacheWritebackInvalidateAll();
+  compositor_mark_all_dirty();
+}
+
+Texture *load_texture_async(const char *filename) {
+  Texture *texture = (Texture *)calloc(1, sizeof(Texture));
+
+  TextureLoad *load = (TextureLoad *)calloc(1, sizeof(TextureLoad));
+  load->filename = filename;
+  load->texture = texture;
+
+  Job job = {.run = decode_texture, .complete = complete_texture_load, .data = load};
+  if (!job_submit(JOB_PRIORITY_LOW, job)) {
+    decode_texture(load);
+    complete_texture_load(load);
+  }
+
+  return texture;
+}
+
 Texture *init_texture(uint32_t width, uint32_t height) {
   Texture *texture = (Texture *)calloc(1, sizeof(Texture));
 
@@ -261,7 +336,7 @@ uint8_t handle_navigation_controls() {
 
   if (section == NAVIGATION_SELECT_STAKE) {
     if (button_pressed(PSP_CTRL_CROSS)) {
-      game_init(state.prev_navigation.hovered, state.navigation.hovered);
+      game_init(state.prev_navigation.hovered, state.navigation.hovered, get_new_run_seed());
       return 1;
     } else if (button_pressed(PSP_CTRL_CIRCLE)) {
       change_overlay(OVERLAY_NONE);
@@ -288,7 +363,13 @@ uint8_t handle_navigation_controls() {
 
 void handle_controls() {
   Controls *controls = &state.controls;
-  sceCtrlReadBufferPositive(&controls->data, 1);
+  sceCtrlPeekBufferPositive(&controls->data, 1);
+
+  // Layout depends only on state changed by input, so it is kept until buttons change
+  if (controls->data.Buttons == controls->state) return;
+  scheduler_notify_input();
+  trace_event(TRACE_EVENT_INPUT, controls->data.Buttons, 0);
+  if (controls->data.Buttons & ~controls->state) counters_begin_action();
 
   if (handle_navigation_controls() == 1 || state.overlay != OVERLAY_NONE) {
     state.controls.state = controls->data.Buttons;
@@ -370,7 +451,7 @@ void handle_controls() {
         Deck current_deck = state.game.deck_type;
         Stake current_stake = state.game.stake;
         game_destroy();
-        game_init(current_deck, current_stake);
+        game_init(current_deck, current_stake, get_new_run_seed());
       }
       break;
   }
@@ -379,17 +460,20 @@ void handle_controls() {
   update_render_commands();
 }
 
-void init_gu(char list[]) {
-  void *fbp0 = guGetStaticVramBuffer(BUFFER_WIDTH, BUFFER_HEIGHT, GU_PSM_8888);
-  void *fbp1 = guGetStaticVramBuffer(BUFFER_WIDTH, BUFFER_HEIGHT, GU_PSM_8888);
+static void gpu_finish_callback(int id) { gpu_finish_time = sceKernelGetSystemTimeWide(); }
+
+void init_gu() {
+  frame_buffers[0] = guGetStaticVramBuffer(BUFFER_WIDTH, BUFFER_HEIGHT, GU_PSM_8888);
+  frame_buffers[1] = guGetStaticVramBuffer(BUFFER_WIDTH, BUFFER_HEIGHT, GU_PSM_8888);
 
   sceGuInit();
+  sceGuSetCallback(GU_CALLBACK_FINISH, gpu_finish_callback);
 
-  sceGuStart(GU_DIRECT, list);
-  sceGuDrawBuffer(GU_PSM_8888, fbp0, BUFFER_WIDTH);
-  sceGuDispBuffer(SCREEN_WIDTH, SCREEN_HEIGHT, fbp1, BUFFER_WIDTH);
+  sceGuStart(GU_DIRECT, display_lists[0]);
+  sceGuDrawBuffer(GU_PSM_8888, frame_buffers[0], BUFFER_WIDTH);
+  sceGuDispBuffer(SCREEN_WIDTH, SCREEN_HEIGHT, frame_buffers[1], BUFFER_WIDTH);
 
-  sceGuDepthBuffer(fbp0, 0);
+  sceGuDepthBuffer(frame_buffers[0], 0);
   sceGuDisable(GU_DEPTH_TEST);
 
   sceGuOffset(2048 - (SCREEN_WIDTH / 2), 2048 - (SCREEN_HEIGHT / 2));
@@ -397,32 +481,112 @@ void init_gu(char list[]) {
   sceGuEnable(GU_SCISSOR_TEST);
   sceGuScissor(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 
-  render_batch.vertices = vertex_buffer;
-
   sceGuFinish();
+  sceGuSync(0, 0);
   sceGuDisplay(GU_TRUE);
 }
 
+static void show_pending_frame() {
+  if (pending_buffer < 0) return;
+
+  sceGuSync(0, 0);
+  scheduler_record_gpu_time(gpu_finish_time - gpu_start_time);
+  trace_event(TRACE_EVENT_GPU, gpu_finish_time - gpu_start_time, 0);
+
+  sceDisplayWaitVblankStart();
+  sceDisplaySetFrameBuf((uint8_t *)sceGeEdramGetAddr() + (uintptr_t)frame_buffers[pending_buffer], BUFFER_WIDTH,
+                        PSP_DISPLAY_PIXEL_FORMAT_8888, PSP_DISPLAY_SETBUF_IMMEDIATE);
+  pending_buffer = -1;
+}
+
 void end_gu() {
+  show_pending_frame();
+  log_message(LOG_INFO, "Display list peak usage: %d/%d bytes.", display_list_peak, DISPLAY_LIST_SIZE);
+
   sceGuDisplay(GU_FALSE);
   sceGuTerm();
 }
 
-void start_frame(char list[]) {
-  sceGuStart(GU_DIRECT, list);
-  sceGuClearColor(0xFF000000);
-  sceGuClear(GU_COLOR_BUFFER_BIT);
+void start_frame(Rect *region) {
+  // List is only sent to GPU when it is finished, buffer it draws to is not shown until then
+  sceGuStart(GU_SEND, display_lists[current_list]);
+  sceGuDrawBufferList(GU_PSM_8888, frame_buffers[draw_buffer], BUFFER_WIDTH);
+  sceGuScissor(region->x, region->y, region->w, region->h);
+  frame_region = *region;
+
+  // Background is opaque, so partially redrawn frame keeps the rest of buffer instead of clearing it
+  if (region->w == SCREEN_WIDTH && region->h == SCREEN_HEIGHT) {
+    sceGuClearColor(0xFF000000);
+    sceGuClear(GU_COLOR_BUFFER_BIT);
+  }
 
   render_batch.count = 0;
+  render_batch.capacity = 0;
 }
 
-void end_frame() {
+void begin_texture_render(Texture *target, Rect *area) {
   flush_render_batch();
 
-  sceGuFinish();
-  sceGuSync(0, 0);
-  sceDisplayWaitVblankStart();
-  sceGuSwapBuffers();
+  // Draw buffer takes address relative to VRAM start
+  sceGuDrawBufferList(GU_PSM_8888, (void *)((uintptr_t)target->data - (uintptr_t)sceGeEdramGetAddr()), target->width);
+  sceGuScissor(area->x, area->y, area->w, area->h);
+
+  // Alpha channel doubles as stencil buffer
+  sceGuClearColor(0);
+  sceGuClearStencil(0);
+  sceGuClear(GU_COLOR_BUFFER_BIT | GU_STENCIL_BUFFER_BIT);
+
+  // Blending would leave alpha of the last layer in texture, so every visible texel sets full alpha through stencil
+  sceGuEnable(GU_ALPHA_TEST);
+  sceGuAlphaFunc(GU_GREATER, 0, 0xFF);
+  sceGuEnable(GU_STENCIL_TEST);
+  sceGuStencilFunc(GU_ALWAYS, 0xFF, 0xFF);
+  sceGuStencilOp(GU_REPLACE, GU_REPLACE, GU_REPLACE);
+}
+
+void end_texture_render() {
+  flush_render_batch();
+
+  sceGuDisable(GU_STENCIL_TEST);
+  sceGuDisable(GU_ALPHA_TEST);
+
+  sceGuDrawBufferList(GU_PSM_8888, frame_buffers[draw_buffer], BUFFER_WIDTH);
+  sceGuScissor(frame_region.x, frame_region.y, frame_region.w, frame_region.h);
+
+  // Texture cache could still hold previous content of rendered area
+  sceGuTexFlush();
+}
+
+void end_frame(uint8_t pipelined) {
+  flush_render_batch();
+
+  int size = sceGuFinish();
+  if (size > display_list_peak) display_list_peak = size;
+  uint64_t finish_time = sceKernelGetSystemTimeWide();
+  scheduler_record_frame(finish_time);
+  trace_event(TRACE_EVENT_FRAME, finish_time - state.scheduler.frame_start, size);
+
+  // Buffer drawn by this frame is still shown until previous frame replaces it
+  show_pending_frame();
+
+  // Vertices were written through data cache, GPU reads the list from memory
+  sceKernelDcacheWritebackRange(display_lists[current_list], size);
+
+  gpu_start_time = sceKernelGetSystemTimeWide();
+  sceGuSendList(GU_TAIL, display_lists[current_list], &ge_context);
+
+  pending_buffer = draw_buffer;
+  draw_buffer ^= 1;
+  current_list ^= 1;
+
+  if (!pipelined) show_pending_frame();
+}
+
+void skip_frame() {
+  if (pending_buffer >= 0)
+    show_pending_frame();
+  else
+    sceDisplayWaitVblankStart();
 }
 
 int exit_callback(int arg1, int arg2, void *common) {
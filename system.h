@@ -6,7 +6,12 @@
 #define BUFFER_WIDTH (512)
 #define BUFFER_HEIGHT SCREEN_HEIGHT
 
-#define RENDER_BATCH_SIZE (512)
+// Busiest layout needs about 30 KB including vertices, so there is twice as much room
+#define DISPLAY_LIST_SIZE (65536)
+// Space at the end of display list kept for commands that draw the last batch and finish the list
+#define DISPLAY_LIST_RESERVE (256)
+// sceGuGetMemory places a jump command in front of the memory it returns
+#define GU_MEMORY_HEADER_SIZE (8)
 
 #define RGB(r, g, b) RGBA(r, g, b, 255)
 #define RGBA(r, g, b, a) ((a << 24) | (b << 16) | (g << 8) | r)
@@ -30,14 +35,19 @@ typedef struct {
   uint32_t *data;
 } Texture;
 
+// Vertices are written straight into display list, right behind its last command,
+// and are committed with sceGuGetMemory when batch is flushed
 typedef struct {
   uint8_t is_angled;
   Vertex *vertices;
   uint16_t count;
+  uint16_t capacity;
   Texture *texture;
 } RenderBatch;
 
 Texture *load_texture(const char *filename);
+// Texture is decoded on job thread, it has no data and isn't drawn until then
+Texture *load_texture_async(const char *filename);
 Texture *init_texture(uint32_t width, uint32_t height);
 
 void flush_render_batch();
@@ -50,10 +60,16 @@ Vector2 draw_text_len(const char *text, uint32_t len, const Vector2 *pos, uint32
 void handle_controls();
 
 int setup_callbacks();
-void init_gu(char list[]);
+void init_gu();
 void end_gu();
 
-void start_frame(char list[]);
-void end_frame();
+void start_frame(Rect *region);
+// Draws into given area of VRAM texture instead of frame buffer until end_texture_render
+void begin_texture_render(Texture *target, Rect *area);
+void end_texture_render();
+// Pipelined frame is shown during the next frame, so building it overlaps with GPU drawing the previous one
+void end_frame(uint8_t pipelined);
+// Shows frame left by pipelined end_frame or only waits for vblank
+void skip_frame();
 
 #endif
@@ -0,0 +1,127 @@
+// Lays out every stage and overlay over a few runs, with each navigable item hovered so its tooltip is laid out too.
+// Fails when a peak goes over the layout budget of its stage or overlay, budgets then have to be raised.
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "content/joker.h"
+#include "game.h"
+#include "gfx.h"
+#include "renderer.h"
+#include "state.h"
+
+#define RUN_COUNT (8)
+#define ROUND_COUNT (3)
+
+State state;
+
+static Texture texture = {.width = 256, .height = 256};
+
+static void lay_out_hovered_items() {
+  Navigation navigation = state.navigation;
+
+  for (uint8_t row = 0; row < MAX_NAV_ROWS; row++) {
+    for (uint8_t col = 0; col < MAX_NAV_SECTIONS_PER_ROW; col++) {
+      state.navigation.cursor = (NavigationCursor){.row = row, .col = col};
+
+      uint8_t size = get_nav_section_size(get_current_section());
+      for (uint8_t i = 0; i < size; i++) {
+        state.navigation.hovered = i;
+        update_render_commands();
+      }
+    }
+  }
+
+  state.navigation = navigation;
+  update_render_commands();
+}
+
+static void lay_out_overlay(Overlay overlay) {
+  change_overlay(overlay);
+  lay_out_hovered_items();
+  change_overlay(OVERLAY_NONE);
+}
+
+// Sidebar and topbar are largest with every slot taken
+static void fill_player_slots(uint32_t seed) {
+  for (uint8_t i = 0; i < state.game.jokers.size; i++) {
+    Joker joker = create_joker(JOKER_JOKER + (seed + i) % JOKER_COUNT, EDITION_POLYCHROME);
+    add_joker_to_player(&joker);
+  }
+
+  Consumable tarot = {.type = CONSUMABLE_TAROT, .tarot = TAROT_FOOL};
+  Consumable planet = {.type = CONSUMABLE_PLANET, .planet = PLANET_PLUTO};
+  cvector_push_back(state.game.consumables.items, tarot);
+  cvector_push_back(state.game.consumables.items, planet);
+}
+
+static void play_run(uint32_t seed) {
+  game_init(DECK_RED, STAKE_WHITE, seed);
+  fill_player_slots(seed);
+
+  for (uint8_t round = 0; round < ROUND_COUNT; round++) {
+    change_stage(STAGE_SELECT_BLIND);
+    lay_out_hovered_items();
+
+    select_blind();
+    for (uint8_t i = 0; i < 5; i++) toggle_card_select(i);
+    lay_out_hovered_items();
+    lay_out_overlay(OVERLAY_POKER_HANDS);
+    lay_out_overlay(OVERLAY_MENU);
+
+    change_stage(STAGE_CASH_OUT);
+    lay_out_hovered_items();
+
+    cash_out();
+    lay_out_hovered_items();
+
+    for (BoosterPackType type = BOOSTER_PACK_STANDARD; type <= BOOSTER_PACK_SPECTRAL; type++) {
+      BoosterPackItem booster_pack = {.type = type, .size = BOOSTER_PACK_MEGA};
+      open_booster_pack(&booster_pack);
+      lay_out_hovered_items();
+      skip_booster_pack();
+    }
+
+    exit_shop();
+  }
+
+  change_stage(STAGE_GAME_OVER);
+  lay_out_hovered_items();
+  game_destroy();
+}
+
+int main() {
+  state.cards_atlas = state.jokers_atlas1 = state.jokers_atlas2 = state.font = state.logo = &texture;
+  state.running = 1;
+  frame_arena_init();
+  renderer_init();
+
+  for (Stage stage = STAGE_MAIN_MENU; stage <= STAGE_CREDITS; stage++) {
+    change_stage(stage);
+    lay_out_hovered_items();
+  }
+  lay_out_overlay(OVERLAY_SELECT_STAKE);
+
+  for (uint32_t seed = 1; seed <= RUN_COUNT; seed++) play_run(seed);
+
+  bool has_failed = state.running == 0;
+  if (has_failed) printf("Clay reported an error, see the log.\n");
+
+  for (uint8_t slot = 0; slot < LAYOUT_SLOT_COUNT; slot++) {
+    // Slot of OVERLAY_NONE is never used, stage slots cover it
+    if (slot == STAGE_COUNT + OVERLAY_NONE) continue;
+
+    const LayoutCounts *peak = get_layout_slot_peak(slot);
+    const LayoutCounts *budget = get_layout_slot_budget(slot);
+    bool is_over_budget = is_over_layout_budget(peak, budget);
+    bool was_laid_out = peak->elements > 0;
+    has_failed |= is_over_budget || !was_laid_out;
+
+    printf("%-4s slot %2d: %3d/%3d elements, %3d/%3d texts, %3d/%3d ids, %3d/%3d words%s\n",
+           is_over_budget || !was_laid_out ? "FAIL" : "ok", slot, peak->elements, budget->elements,
+           peak->text_elements, budget->text_elements, peak->element_ids, budget->element_ids, peak->measured_words,
+           budget->measured_words, was_laid_out ? "" : " (never laid out)");
+  }
+
+  return has_failed ? 1 : 0;
+}
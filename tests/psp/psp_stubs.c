@@ -0,0 +1,108 @@
+// Stand-ins for PSP SDK functions, so game code can run on host in tests.
+// Display list is emulated closely enough for render batching, everything else does nothing.
+
+#include <pspctrl.h>
+#include <pspdisplay.h>
+#include <pspge.h>
+#include <pspgu.h>
+#include <pspkernel.h>
+#include <stb_image.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Every command takes a single word, like most of them do on real hardware
+#define COMMAND_SIZE (4)
+#define MEMORY_HEADER_SIZE (8)
+// Arguments don't matter to tests, only that command words take their place in the list
+#define COMMAND_WORD (0xC0DEC0DE)
+
+static char *list_start = NULL;
+static int list_size = 0;
+
+// Like on hardware, command is written at the end of list, over anything that was placed there before
+static void add_command() {
+  *(uint32_t *)(list_start + list_size) = COMMAND_WORD;
+  list_size += COMMAND_SIZE;
+}
+
+void sceGuInit(void) {}
+void sceGuTerm(void) {}
+
+void sceGuStart(int context_type, void *list) {
+  list_start = list;
+  list_size = 0;
+}
+
+int sceGuFinish(void) { return list_size; }
+int sceGuSync(int mode, int what) { return 0; }
+int sceGuCheckList(void) { return list_size; }
+void sceGuSendList(int mode, const void *list, PspGeContext *context) {}
+
+// Memory follows a jump over it, so the block starts right after the header at the end of list
+void *sceGuGetMemory(int size) {
+  size = (size + 3) & ~3;
+  for (int i = 0; i < MEMORY_HEADER_SIZE; i += COMMAND_SIZE) add_command();
+
+  void *memory = list_start + list_size;
+  list_size += size;
+  return memory;
+}
+
+void *sceGuSetCallback(int signal, void (*callback)(int)) { return NULL; }
+
+void sceGuDepthBuffer(void *zbp, int zbw) {}
+void sceGuDispBuffer(int width, int height, void *dispbp, int dispbw) {}
+void sceGuDrawBuffer(int psm, void *fbp, int fbw) {}
+void sceGuDrawBufferList(int psm, void *fbp, int fbw) { add_command(); }
+int sceGuDisplay(int state) { return state; }
+void sceGuOffset(unsigned int x, unsigned int y) {}
+void sceGuViewport(int cx, int cy, int width, int height) {}
+void sceGuScissor(int x, int y, int w, int h) { add_command(); }
+
+void sceGuEnable(int state) { add_command(); }
+void sceGuDisable(int state) { add_command(); }
+void sceGuClear(int flags) { add_command(); }
+void sceGuClearColor(unsigned int color) { add_command(); }
+void sceGuClearStencil(unsigned int stencil) { add_command(); }
+void sceGuAlphaFunc(int func, int value, int mask) { add_command(); }
+void sceGuStencilFunc(int func, int ref, int mask) { add_command(); }
+void sceGuStencilOp(int fail, int zfail, int zpass) { add_command(); }
+void sceGuBlendFunc(int op, int src, int dest, unsigned int srcfix, unsigned int destfix) { add_command(); }
+
+void sceGuTexMode(int tpsm, int maxmips, int a2, int swizzle) { add_command(); }
+void sceGuTexImage(int mipmap, int width, int height, int tbw, const void *tbp) { add_command(); }
+void sceGuTexFilter(int min, int mag) { add_command(); }
+void sceGuTexWrap(int u, int v) { add_command(); }
+void sceGuTexFunc(int tfx, int tcc) { add_command(); }
+void sceGuTexFlush(void) { add_command(); }
+
+void sceGuDrawArray(int prim, int vtype, int count, const void *indices, const void *vertices) { add_command(); }
+
+static char vram[4096];
+void *guGetStaticVramBuffer(unsigned int width, unsigned int height, unsigned int psm) { return NULL; }
+void *guGetStaticVramTexture(unsigned int width, unsigned int height, unsigned int psm) { return vram; }
+void *sceGeEdramGetAddr(void) { return vram; }
+
+int sceDisplayWaitVblankStart(void) { return 0; }
+int sceDisplaySetFrameBuf(void *top_address, int buffer_width, int pixel_format, int sync) { return 0; }
+
+int sceCtrlSetSamplingCycle(int cycle) { return 0; }
+int sceCtrlSetSamplingMode(int mode) { return 0; }
+int sceCtrlPeekBufferPositive(SceCtrlData *pad_data, int count) { return 0; }
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int priority, int stack_size,
+                             SceUInt attributes, void *options) {
+  return -1;
+}
+int sceKernelStartThread(SceUID thread, SceSize args, void *argp) { return -1; }
+int sceKernelSleepThreadCB(void) { return 0; }
+int sceKernelCreateCallback(const char *name, SceKernelCallbackFunction function, void *arg) { return -1; }
+int sceKernelRegisterExitCallback(int callback) { return 0; }
+SceInt64 sceKernelGetSystemTimeWide(void) { return 0; }
+void sceKernelDcacheWritebackInvalidateAll(void) {}
+void sceKernelDcacheWritebackRange(const void *address, unsigned int size) {}
+
+// Textures stay empty, drawing skips them like the ones that are still being decoded
+unsigned char *stbi_load(const char *filename, int *x, int *y, int *channels, int desired_channels) { return NULL; }
+void stbi_image_free(void *data) { free(data); }
@@ -0,0 +1,35 @@
+#ifndef PSPCTRL_H
+#define PSPCTRL_H
+
+#include "psptypes.h"
+
+enum {
+  PSP_CTRL_SELECT = 0x1,
+  PSP_CTRL_START = 0x8,
+  PSP_CTRL_UP = 0x10,
+  PSP_CTRL_RIGHT = 0x20,
+  PSP_CTRL_DOWN = 0x40,
+  PSP_CTRL_LEFT = 0x80,
+  PSP_CTRL_LTRIGGER = 0x100,
+  PSP_CTRL_RTRIGGER = 0x200,
+  PSP_CTRL_TRIANGLE = 0x1000,
+  PSP_CTRL_CIRCLE = 0x2000,
+  PSP_CTRL_CROSS = 0x4000,
+  PSP_CTRL_SQUARE = 0x8000,
+};
+
+#define PSP_CTRL_MODE_ANALOG (1)
+
+typedef struct {
+  unsigned int TimeStamp;
+  unsigned int Buttons;
+  unsigned char Lx;
+  unsigned char Ly;
+  unsigned char Rsrv[6];
+} SceCtrlData;
+
+int sceCtrlSetSamplingCycle(int cycle);
+int sceCtrlSetSamplingMode(int mode);
+int sceCtrlPeekBufferPositive(SceCtrlData *pad_data, int count);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef PSPDISPLAY_H
+#define PSPDISPLAY_H
+
+#define PSP_DISPLAY_PIXEL_FORMAT_8888 (3)
+#define PSP_DISPLAY_SETBUF_IMMEDIATE (0)
+
+int sceDisplayWaitVblankStart(void);
+int sceDisplaySetFrameBuf(void *top_address, int buffer_width, int pixel_format, int sync);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef PSPGE_H
+#define PSPGE_H
+
+typedef struct {
+  unsigned int context[512];
+} PspGeContext;
+
+void *sceGeEdramGetAddr(void);
+
+#endif
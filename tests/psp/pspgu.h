@@ -0,0 +1,84 @@
+#ifndef PSPGU_H
+#define PSPGU_H
+
+#include "pspge.h"
+
+#define GU_FALSE (0)
+#define GU_TRUE (1)
+
+#define GU_TRIANGLES (3)
+#define GU_SPRITES (6)
+
+#define GU_ALPHA_TEST (0)
+#define GU_DEPTH_TEST (1)
+#define GU_SCISSOR_TEST (2)
+#define GU_STENCIL_TEST (3)
+#define GU_BLEND (4)
+#define GU_TEXTURE_2D (9)
+
+#define GU_TEXTURE_32BITF (3 << 0)
+#define GU_COLOR_8888 (7 << 2)
+#define GU_VERTEX_32BITF (3 << 7)
+#define GU_TRANSFORM_2D (1 << 23)
+
+#define GU_PSM_8888 (3)
+#define GU_NEAREST (0)
+#define GU_LINEAR (1)
+#define GU_REPEAT (0)
+#define GU_TFX_MODULATE (0)
+#define GU_TCC_RGBA (1)
+#define GU_ADD (0)
+#define GU_SRC_ALPHA (2)
+#define GU_ONE_MINUS_SRC_ALPHA (3)
+#define GU_COLOR_BUFFER_BIT (1)
+#define GU_STENCIL_BUFFER_BIT (2)
+#define GU_DIRECT (0)
+#define GU_SEND (2)
+#define GU_TAIL (0)
+#define GU_ALWAYS (1)
+#define GU_GREATER (6)
+#define GU_REPLACE (2)
+#define GU_CALLBACK_FINISH (4)
+
+void sceGuInit(void);
+void sceGuTerm(void);
+void sceGuStart(int context_type, void *list);
+int sceGuFinish(void);
+int sceGuSync(int mode, int what);
+int sceGuCheckList(void);
+void sceGuSendList(int mode, const void *list, PspGeContext *context);
+void *sceGuGetMemory(int size);
+void *sceGuSetCallback(int signal, void (*callback)(int));
+
+void sceGuDepthBuffer(void *zbp, int zbw);
+void sceGuDispBuffer(int width, int height, void *dispbp, int dispbw);
+void sceGuDrawBuffer(int psm, void *fbp, int fbw);
+void sceGuDrawBufferList(int psm, void *fbp, int fbw);
+int sceGuDisplay(int state);
+void sceGuOffset(unsigned int x, unsigned int y);
+void sceGuViewport(int cx, int cy, int width, int height);
+void sceGuScissor(int x, int y, int w, int h);
+
+void sceGuEnable(int state);
+void sceGuDisable(int state);
+void sceGuClear(int flags);
+void sceGuClearColor(unsigned int color);
+void sceGuClearStencil(unsigned int stencil);
+void sceGuAlphaFunc(int func, int value, int mask);
+void sceGuStencilFunc(int func, int ref, int mask);
+void sceGuStencilOp(int fail, int zfail, int zpass);
+void sceGuBlendFunc(int op, int src, int dest, unsigned int srcfix, unsigned int destfix);
+
+void sceGuTexMode(int tpsm, int maxmips, int a2, int swizzle);
+void sceGuTexImage(int mipmap, int width, int height, int tbw, const void *tbp);
+void sceGuTexFilter(int min, int mag);
+void sceGuTexWrap(int u, int v);
+void sceGuTexFunc(int tfx, int tcc);
+void sceGuTexFlush(void);
+
+void sceGuDrawArray(int prim, int vtype, int count, const void *indices, const void *vertices);
+
+void *guGetStaticVramBuffer(unsigned int width, unsigned int height, unsigned int psm);
+void *guGetStaticVramTexture(unsigned int width, unsigned int height, unsigned int psm);
+
+#endif
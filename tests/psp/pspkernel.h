@@ -0,0 +1,10 @@
+#ifndef PSPKERNEL_H
+#define PSPKERNEL_H
+
+#include "pspthreadman.h"
+#include "psptypes.h"
+
+void sceKernelDcacheWritebackInvalidateAll(void);
+void sceKernelDcacheWritebackRange(const void *address, unsigned int size);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef PSPTHREADMAN_H
+#define PSPTHREADMAN_H
+
+#include "psptypes.h"
+
+#define PSP_THREAD_ATTR_USER (0x80000000)
+
+typedef int (*SceKernelThreadEntry)(SceSize args, void *argp);
+typedef int (*SceKernelCallbackFunction)(int arg1, int arg2, void *common);
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int priority, int stack_size,
+                             SceUInt attributes, void *options);
+int sceKernelStartThread(SceUID thread, SceSize args, void *argp);
+int sceKernelSleepThreadCB(void);
+int sceKernelCreateCallback(const char *name, SceKernelCallbackFunction function, void *arg);
+int sceKernelRegisterExitCallback(int callback);
+SceInt64 sceKernelGetSystemTimeWide(void);
+
+#endif
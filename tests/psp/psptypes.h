@@ -0,0 +1,13 @@
+#ifndef PSPTYPES_H
+#define PSPTYPES_H
+
+#include <stdint.h>
+
+typedef int SceUID;
+typedef unsigned int SceSize;
+typedef unsigned int SceUInt;
+typedef unsigned int SceUInt32;
+typedef long long SceInt64;
+typedef int SceMode;
+
+#endif
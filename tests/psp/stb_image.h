@@ -0,0 +1,9 @@
+#ifndef STB_IMAGE_H
+#define STB_IMAGE_H
+
+#define STBI_rgb_alpha (4)
+
+unsigned char *stbi_load(const char *filename, int *x, int *y, int *channels, int desired_channels);
+void stbi_image_free(void *data);
+
+#endif
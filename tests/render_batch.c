@@ -0,0 +1,117 @@
+// Reserves and commits render batches against emulated display list allocator from psp directory.
+// Fails when a batch doesn't end up where GPU reads it, or a batch whose vertices could be overwritten is drawn.
+
+#include "render_batch.h"
+
+#include <pspgu.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static char __attribute__((aligned(16))) list[DISPLAY_LIST_SIZE];
+static bool has_failed = false;
+
+static void check(bool condition, const char *name) {
+  printf("%-4s %s\n", condition ? "ok" : "FAIL", name);
+  has_failed |= !condition;
+}
+
+static void fill_batch(RenderBatch *batch, uint16_t count) {
+  for (batch->count = 0; batch->count < count; batch->count++)
+    batch->vertices[batch->count] = (Vertex){.u = 1, .x = batch->count, .y = 1, .color = 0xFFFFFFFF};
+}
+
+static bool has_vertices(Vertex *vertices, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++)
+    if (vertices[i].u != 1 || vertices[i].x != i || vertices[i].y != 1 || vertices[i].color != 0xFFFFFFFF) return false;
+  return true;
+}
+
+static void test_batch_in_place() {
+  sceGuStart(GU_DIRECT, list);
+  sceGuEnable(GU_BLEND);
+
+  RenderBatch batch = {0};
+  reserve_render_batch(&batch, list, sceGuCheckList());
+  fill_batch(&batch, 6);
+  Vertex *reserved = batch.vertices;
+
+  check(commit_render_batch(&batch, sceGuGetMemory(batch.count * sizeof(Vertex))), "batch is committed in place");
+  check(batch.vertices == reserved && has_vertices(batch.vertices, 6), "vertices stay where they were written");
+  check(sceGuCheckList() == 4 + GU_MEMORY_HEADER_SIZE + 6 * sizeof(Vertex), "list ends right behind vertices");
+}
+
+static void test_list_grown_since_reservation() {
+  sceGuStart(GU_DIRECT, list);
+
+  RenderBatch batch = {0};
+  reserve_render_batch(&batch, list, sceGuCheckList());
+  fill_batch(&batch, 12);
+
+  // Command added before commit takes the place where vertices were reserved
+  sceGuTexFlush();
+  check(!commit_render_batch(&batch, sceGuGetMemory(batch.count * sizeof(Vertex))), "grown list is reported");
+  check(batch.count == 0, "batch of grown list is dropped");
+}
+
+static void test_commands_interleaved_with_batch() {
+  sceGuStart(GU_DIRECT, list);
+  sceGuEnable(GU_BLEND);
+
+  RenderBatch batch = {0};
+  reserve_render_batch(&batch, list, sceGuCheckList());
+  fill_batch(&batch, 12);
+  Vertex *reserved = batch.vertices;
+
+  sceGuTexFlush();
+  sceGuEnable(GU_TEXTURE_2D);
+  sceGuDisable(GU_BLEND);
+  check(!has_vertices(reserved, 12), "third command overwrites reserved vertices");
+
+  static char commands[DISPLAY_LIST_SIZE];
+  int used = sceGuCheckList();
+  memcpy(commands, list, used);
+
+  check(!commit_render_batch(&batch, sceGuGetMemory(batch.count * sizeof(Vertex))), "grown list is reported");
+  check(batch.count == 0, "batch with overwritten vertices is dropped");
+  check(memcmp(commands, list, used) == 0, "commands stay in list");
+}
+
+static void test_consecutive_batches() {
+  sceGuStart(GU_DIRECT, list);
+
+  RenderBatch batch = {0};
+  reserve_render_batch(&batch, list, sceGuCheckList());
+  fill_batch(&batch, 2);
+  commit_render_batch(&batch, sceGuGetMemory(batch.count * sizeof(Vertex)));
+  Vertex *first = batch.vertices;
+  sceGuDrawArray(GU_SPRITES, 0, batch.count, NULL, batch.vertices);
+
+  reserve_render_batch(&batch, list, sceGuCheckList());
+  fill_batch(&batch, 6);
+  check(commit_render_batch(&batch, sceGuGetMemory(batch.count * sizeof(Vertex))), "second batch is in place");
+  check(has_vertices(first, 2) && has_vertices(batch.vertices, 6), "second batch keeps vertices of the first one");
+}
+
+static void test_capacity() {
+  RenderBatch batch = {0};
+  reserve_render_batch(&batch, list, 0);
+  int available = DISPLAY_LIST_SIZE - DISPLAY_LIST_RESERVE - GU_MEMORY_HEADER_SIZE;
+  check(batch.capacity == available / sizeof(Vertex), "empty list leaves everything except reserve to the batch");
+
+  reserve_render_batch(&batch, list, DISPLAY_LIST_SIZE - DISPLAY_LIST_RESERVE - GU_MEMORY_HEADER_SIZE - 1);
+  check(batch.capacity == 0, "no vertex fits in less than its size");
+
+  reserve_render_batch(&batch, list, DISPLAY_LIST_SIZE - DISPLAY_LIST_RESERVE);
+  check(batch.capacity == 0, "reserve is never given to the batch");
+}
+
+int main() {
+  test_batch_in_place();
+  test_list_grown_since_reservation();
+  test_commands_interleaved_with_batch();
+  test_consecutive_batches();
+  test_capacity();
+
+  return has_failed ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+// Saves a run over and over into a temporary directory, damaging slots and failing writes in between.
+// Fails when a save lands in the wrong slot or a damaged or failed slot is taken as the latest one.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "renderer.h"
+#include "save.h"
+#include "state.h"
+
+State state;
+
+static Texture texture = {.width = 64, .height = 64};
+
+static char directory[] = "save_slots_XXXXXX";
+// Directory with separator, as save_init takes it
+static char save_directory[SAVE_PATH_SIZE];
+static char slot_paths[SAVE_SLOT_COUNT][SAVE_PATH_SIZE];
+static bool has_failed = false;
+
+static void check(bool condition, const char *name) {
+  printf("%-4s %s\n", condition ? "ok" : "FAIL", name);
+  has_failed |= !condition;
+}
+
+// Sequence of the save in slot, -1 when slot can't be read
+static int64_t get_slot_sequence(uint8_t slot) {
+  FILE *file = fopen(slot_paths[slot], "rb");
+  if (file == NULL) return -1;
+
+  SaveHeader header;
+  bool is_read = fread(&header, sizeof(SaveHeader), 1, file) == 1;
+  fclose(file);
+  return is_read ? (int64_t)header.sequence : -1;
+}
+
+static bool has_slot_sequences(int64_t first, int64_t second) {
+  return get_slot_sequence(0) == first && get_slot_sequence(1) == second;
+}
+
+static void damage_slot(uint8_t slot, long offset) {
+  FILE *file = fopen(slot_paths[slot], "r+b");
+  fseek(file, offset, SEEK_SET);
+  int byte = fgetc(file);
+  fseek(file, offset, SEEK_SET);
+  fputc(byte ^ 0xFF, file);
+  fclose(file);
+}
+
+static void test_not_initialized() {
+  // Without save_init slots would go to working directory
+  chdir(directory);
+  save_game();
+  check(access("save_a.bin", F_OK) != 0 && access("save_b.bin", F_OK) != 0, "nothing is saved before save_init");
+  chdir("..");
+}
+
+static void test_slot_alternation() {
+  save_init(save_directory);
+  save_game();
+  check(has_slot_sequences(0, -1), "first save goes to the first slot");
+  save_game();
+  save_game();
+  check(has_slot_sequences(2, 1), "saves alternate between slots");
+}
+
+// Damaged slot always holds the latest save, if it were taken the next save would go to the other slot
+static void test_bad_checksum() {
+  // Header stays readable, only checksum tells that data is damaged
+  damage_slot(0, sizeof(SaveHeader) + 1);
+  save_init(save_directory);
+  save_game();
+  check(has_slot_sequences(2, 1), "slot with bad checksum is written again");
+}
+
+static void test_truncated_slot() {
+  truncate(slot_paths[0], sizeof(SaveHeader) + 1);
+  save_init(save_directory);
+  save_game();
+  check(has_slot_sequences(2, 1), "truncated slot is written again");
+}
+
+static void test_failed_write() {
+  // Directory in place of the slot can't be opened as a file
+  remove(slot_paths[1]);
+  mkdir(slot_paths[1], 0700);
+  save_game();
+  check(has_slot_sequences(2, -1), "failed write keeps the other slot");
+
+  rmdir(slot_paths[1]);
+  save_game();
+  check(has_slot_sequences(2, 3), "failed slot is written again by the next save");
+  save_game();
+  check(has_slot_sequences(4, 3), "saves alternate again after failed write");
+}
+
+static void test_latest_slot() {
+  save_init(save_directory);
+  save_game();
+  check(has_slot_sequences(4, 5), "save_init continues after the latest slot");
+}
+
+int main() {
+  state.cards_atlas = state.jokers_atlas1 = state.jokers_atlas2 = state.font = state.bg = state.logo = &texture;
+  frame_arena_init();
+  renderer_init();
+  game_init(DECK_RED, STAKE_WHITE, 1);
+
+  if (mkdtemp(directory) == NULL) return 1;
+  snprintf(save_directory, SAVE_PATH_SIZE, "%s/", directory);
+  snprintf(slot_paths[0], SAVE_PATH_SIZE, "%ssave_a.bin", save_directory);
+  snprintf(slot_paths[1], SAVE_PATH_SIZE, "%ssave_b.bin", save_directory);
+
+  test_not_initialized();
+  test_slot_alternation();
+  test_bad_checksum();
+  test_truncated_slot();
+  test_failed_write();
+  test_latest_slot();
+
+  remove(slot_paths[0]);
+  remove(slot_paths[1]);
+  rmdir(directory);
+  game_destroy();
+
+  return has_failed ? 1 : 0;
+}
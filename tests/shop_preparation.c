@@ -0,0 +1,126 @@
+// Plays every seed twice without preparing the next Shop and once preparing it for a varying number of frames.
+// Fails when a seed doesn't replay the same run, any Shop differs with preparation or prepared Shops are never used.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "counters.h"
+#include "game.h"
+#include "random.h"
+#include "renderer.h"
+#include "score.h"
+#include "state.h"
+
+#define SEED_COUNT (40)
+#define ROUND_COUNT (14)
+#define SHOP_LOG_SIZE (8192)
+
+State state;
+
+static Texture texture = {.width = 64, .height = 64};
+
+// Shops without a single Shop stream draw in restock_shop were prepared in whole
+static uint32_t prepared_shops = 0;
+
+static void prepare(uint8_t frames) {
+  for (uint8_t i = 0; i < frames; i++) prepare_next_shop();
+}
+
+static void log_shop(char *log, size_t *length) {
+  *length += snprintf(log + *length, SHOP_LOG_SIZE - *length, "ante %d round %d items", state.game.ante,
+                      state.game.round);
+  cvector_for_each(state.game.shop.items, ShopItem, item) {
+    *length += snprintf(log + *length, SHOP_LOG_SIZE - *length, " %d/%d/%d/%d/%d/%d/%d", item->type, item->is_free,
+                        item->joker.id, item->joker.edition, item->card.suit, item->card.rank, item->planet);
+  }
+
+  *length += snprintf(log + *length, SHOP_LOG_SIZE - *length, " packs");
+  cvector_for_each(state.game.shop.booster_packs, BoosterPackItem, pack) {
+    *length += snprintf(log + *length, SHOP_LOG_SIZE - *length, " %d/%d/%d", pack->type, pack->size, pack->is_free);
+  }
+
+  *length += snprintf(log + *length, SHOP_LOG_SIZE - *length, " vouchers");
+  cvector_for_each(state.game.shop.vouchers, Voucher, voucher) {
+    *length += snprintf(log + *length, SHOP_LOG_SIZE - *length, " %x", *voucher);
+  }
+
+  *length += snprintf(log + *length, SHOP_LOG_SIZE - *length, " at %llx/%llx\n",
+                      (unsigned long long)get_random_position(RANDOM_SUBSYSTEM_SHOP),
+                      (unsigned long long)get_random_position(RANDOM_SUBSYSTEM_EDITION));
+}
+
+// Frames is number of prepare_next_shop calls between player actions, 0 never prepares anything
+static void play_run(uint32_t seed, uint8_t frames, char *log) {
+  size_t length = 0;
+  log[0] = '\0';
+
+  game_init(DECK_RED, STAKE_WHITE, seed);
+
+  for (uint8_t round = 0; round < ROUND_COUNT && state.stage != STAGE_GAME_OVER; round++) {
+    change_stage(STAGE_SELECT_BLIND);
+    // Some blinds are skipped to collect tags, which change the Shop
+    if (state.game.current_blind->type <= BLIND_BIG && (seed + round) % 3 == 0) {
+      skip_blind();
+      continue;
+    }
+
+    select_blind();
+    prepare(frames);
+
+    for (uint8_t hands = 0; state.stage == STAGE_GAME && hands < 10; hands++) {
+      for (uint8_t i = 0; i < 5 && i < cvector_size(state.game.hand.cards); i++) toggle_card_select(i);
+      // Second hand beats the blind, so the Shop is prepared both before and after the last hand
+      if (hands == 1 || state.game.hands.remaining == 1) state.game.score = score_from_double(1e300);
+      play_hand();
+      prepare(frames);
+    }
+    if (state.stage != STAGE_CASH_OUT) break;
+
+    uint32_t shop_draws = get_counter_total(COUNTER_RANDOM_SHOP);
+    cash_out();
+    if (frames > 0 && get_counter_total(COUNTER_RANDOM_SHOP) == shop_draws) prepared_shops++;
+    log_shop(log, &length);
+
+    // Rerolls move the Shop stream within the ante
+    if (round % 2 == 1) {
+      state.game.money = 100;
+      reroll_shop_items();
+    }
+    exit_shop();
+  }
+
+  game_destroy();
+}
+
+int main() {
+  state.cards_atlas = state.jokers_atlas1 = state.jokers_atlas2 = state.font = state.bg = state.logo = &texture;
+  frame_arena_init();
+  renderer_init();
+
+  static char expected[SHOP_LOG_SIZE], actual[SHOP_LOG_SIZE];
+  bool has_failed = false;
+
+  for (uint32_t seed = 1; seed <= SEED_COUNT; seed++) {
+    play_run(seed, 0, expected);
+    // Anything left over from the previous run or taken from outside of the seed would show up as a difference below
+    play_run(seed, 0, actual);
+    if (strcmp(expected, actual) != 0) {
+      printf("FAIL seed %u is not replayed\nfirst run:\n%ssecond run:\n%s", seed, expected, actual);
+      has_failed = true;
+      continue;
+    }
+
+    // Up to 7 frames, so some Shops are only partly prepared when the blind is beaten
+    play_run(seed, seed % 8, actual);
+
+    if (strcmp(expected, actual) == 0) continue;
+    printf("FAIL seed %u\nwithout preparation:\n%swith preparation:\n%s", seed, expected, actual);
+    has_failed = true;
+  }
+
+  printf("%u Shops were prepared in whole\n", prepared_shops);
+  if (prepared_shops == 0) has_failed = true;
+
+  return has_failed ? 1 : 0;
+}
@@ -1,8 +1,24 @@
 #include "text.h"
 
+#include <string.h>
+
+#include "arena.h"
 #include "game.h"
 #include "state.h"
 
+// Must be a power of two
+#define WRAPPED_TEXT_CACHE_SIZE (256)
+#define WRAPPED_TEXT_ARENA_CAPACITY (8192)
+
+typedef struct {
+  const char *source;
+  uint8_t line_length;
+  Clay_String wrapped;
+} WrappedText;
+
+static WrappedText wrapped_text_cache[WRAPPED_TEXT_CACHE_SIZE];
+static Arena wrapped_text_arena;
+
 char *get_poker_hand_name(uint16_t hand_union) {
   switch (get_poker_hand(hand_union)) {
     case HAND_FLUSH_FIVE:
@@ -657,3 +673,64 @@ char *get_tag_description(Tag tag) {
       return "Doubles your money (adds a maximum of $40).";
   }
 }
+
+static void break_lines(char *chars, int32_t length, uint8_t line_length) {
+  int32_t line_start = 0;
+  int32_t last_space = -1;
+
+  for (int32_t i = 0; i < length; i++) {
+    if (chars[i] == '\n') {
+      line_start = i + 1;
+      last_space = -1;
+      continue;
+    }
+
+    if (chars[i] == ' ') last_space = i;
+
+    // Words longer than a whole line are left as they are
+    if (i - line_start >= line_length && last_space >= line_start) {
+      chars[last_space] = '\n';
+      line_start = last_space + 1;
+      last_space = -1;
+    }
+  }
+}
+
+Clay_String wrap_text(Clay_String text, uint8_t line_length) {
+  if (text.length <= line_length) return text;
+
+  // Strings formatted into frame arena are owned by us, so they can be wrapped in place
+  if (!text.isStaticallyAllocated) {
+    break_lines((char *)text.chars, text.length, line_length);
+    return text;
+  }
+
+  // Static strings never change, so each of them is wrapped only once
+  uint32_t slot = ((uintptr_t)text.chars >> 2) & (WRAPPED_TEXT_CACHE_SIZE - 1);
+  for (uint32_t probe = 0; probe < WRAPPED_TEXT_CACHE_SIZE; probe++) {
+    WrappedText *entry = &wrapped_text_cache[(slot + probe) & (WRAPPED_TEXT_CACHE_SIZE - 1)];
+
+    if (entry->source == text.chars && entry->line_length == line_length) return entry->wrapped;
+    if (entry->source != NULL) continue;
+
+    if (wrapped_text_arena.name == NULL)
+      arena_init(&wrapped_text_arena, "Wrapped text", WRAPPED_TEXT_ARENA_CAPACITY);
+
+    char *chars = arena_allocate(&wrapped_text_arena, text.length);
+    if (chars == NULL) break;
+
+    memcpy(chars, text.chars, text.length);
+    break_lines(chars, text.length, line_length);
+
+    entry->source = text.chars;
+    entry->line_length = line_length;
+    entry->wrapped = (Clay_String){.isStaticallyAllocated = 1, .length = text.length, .chars = chars};
+    return entry->wrapped;
+  }
+
+  // Cache is full, wrap a temporary copy instead
+  Clay_String wrapped;
+  append_clay_string(&wrapped, "%.*s", text.length, text.chars);
+  break_lines((char *)wrapped.chars, wrapped.length, line_length);
+  return wrapped;
+}
@@ -32,4 +32,7 @@ char *get_blind_description(BlindType blind_type);
 char *get_tag_name(Tag tag);
 char *get_tag_description(Tag tag);
 
+// Replaces spaces with line breaks, so no line is longer than given number of characters
+Clay_String wrap_text(Clay_String text, uint8_t line_length);
+
 #endif
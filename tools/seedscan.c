@@ -0,0 +1,464 @@
+// Host tool which searches seeds for runs with wanted tags, boss blinds and shop content. Only rolls are evaluated,
+// using the same code as the game, so millions of seeds can be checked in seconds.
+// Build with: cc -O2 -Ilib -o joker-seedscan tools/seedscan.c roll.c random.c counters.c content/joker_info.c
+// Usage: joker-seedscan [-s first seed] [-n seed count] [-j jobs] [-a antes] [-d deck] [-v] predicate...
+//
+// Predicates have form kind:name[@ante] and all of them have to match, e.g. "tag:negative@1 pack:buffoon-mega@1".
+// Kinds are tag, boss, voucher, pack, joker, edition (of a joker), tarot, planet and spectral. Names are lowercase
+// with underscores instead of spaces, pack names are type optionally followed by size, e.g. arcana or arcana-jumbo.
+// Ante is the one shown in game when item is offered, without it any ante up to -a matches.
+// Run is followed without skipping blinds or buying anything and every booster pack in the Shop is opened.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../random.h"
+#include "../roll.h"
+
+#define MAX_PREDICATES (32)
+#define MAX_FINDINGS (1024)
+#define MAX_JOKER_NAME_LENGTH (32)
+
+typedef enum {
+  FINDING_TAG,
+  FINDING_BOSS,
+  FINDING_VOUCHER,
+  FINDING_PACK,
+  FINDING_JOKER,
+  FINDING_EDITION,
+  FINDING_TAROT,
+  FINDING_PLANET,
+  FINDING_SPECTRAL,
+  FINDING_KIND_COUNT
+} FindingKind;
+
+typedef struct {
+  FindingKind kind;
+  uint8_t value;
+  uint8_t ante;
+} Finding;
+
+// Matches findings of given kind with value in range, ante 0 matches any ante
+typedef struct {
+  FindingKind kind;
+  uint8_t first;
+  uint8_t last;
+  uint8_t ante;
+} Predicate;
+
+typedef struct {
+  RollContext context;
+  uint32_t owned_jokers[JOKER_ID_WORDS];
+  uint8_t round;
+  uint8_t shop_size;
+  BlindType boss;
+  Voucher shop_voucher;
+
+  Finding findings[MAX_FINDINGS];
+  uint16_t finding_count;
+  // Bit for each predicate which was matched by some finding
+  uint32_t matched;
+} Run;
+
+typedef struct {
+  const char *kind;
+  const char **names;
+  uint8_t count;
+} FindingNames;
+
+// Names are in order of game enums
+static const char *TAG_NAMES[] = {
+    "uncommon", "rare",     "negative", "foil",    "holographic", "polychrome", "investment", "voucher",
+    "boss",     "standard", "charm",    "meteor",  "buffoon",     "handy",      "garbage",    "ethereal",
+    "coupon",   "double",   "juggle",   "d6",      "topup",       "speed",      "orbital",    "economy"};
+static const char *BOSS_NAMES[] = {
+    "small",   "big",     "hook",  "ox",          "house",        "wall",          "wheel",        "arm",
+    "club",    "fish",    "psychic", "goad",      "water",        "window",        "manacle",      "eye",
+    "mouth",   "plant",   "serpent", "pillar",    "needle",       "head",          "tooth",        "flint",
+    "mark",    "amber_acorn", "verdant_leaf", "violet_vessel", "crimson_heart", "cerulean_bell"};
+static const char *VOUCHER_NAMES[] = {
+    "overstock",      "clearance_sale", "hone",         "reroll_surplus", "crystal_ball", "telescope",
+    "grabber",        "wasteful",       "tarot_merchant", "planet_merchant", "seed_money", "blank",
+    "magic_trick",    "hieroglyph",     "directors_cut", "paint_brush",   "overstock_plus", "liquidation",
+    "glow_up",        "reroll_glut",    "omen_globe",   "observatory",    "nacho_tong",   "recyclomancy",
+    "tarot_tycoon",   "planet_tycoon",  "money_tree",   "antimatter",     "illusion",     "pteroglyph",
+    "retcon",         "palette"};
+static const char *PACK_NAMES[] = {
+    "standard-normal",  "standard-jumbo",  "standard-mega", "arcana-normal",   "arcana-jumbo",
+    "arcana-mega",      "celestial-normal", "celestial-jumbo", "celestial-mega", "buffoon-normal",
+    "buffoon-jumbo",    "buffoon-mega",    "spectral-normal", "spectral-jumbo", "spectral-mega"};
+static const char *EDITION_NAMES[] = {"base", "foil", "holographic", "polychrome", "negative"};
+static const char *TAROT_NAMES[] = {
+    "fool",    "magician", "high_priestess", "empress", "emperor",    "hierophant", "lovers", "chariot",
+    "justice", "hermit",   "wheel_of_fortune", "strength", "hanged_man", "death",   "temperance", "devil",
+    "tower",   "star",     "moon",           "sun",     "judgement",  "world"};
+static const char *PLANET_NAMES[] = {"eris",    "ceres", "planet_x", "neptune", "mars",    "earth",
+                                     "jupiter", "saturn", "venus",   "uranus",  "mercury", "pluto"};
+static const char *SPECTRAL_NAMES[] = {"familiar", "grim",    "incantation", "talisman", "aura",     "wraith",
+                                       "sigil",    "ouija",   "ectoplasm",   "immolate", "ankh",     "deja_vu",
+                                       "hex",      "trance",  "medium",      "cryptid",  "soul",     "black_hole"};
+static const char *DECK_NAMES[] = {"red",    "blue",      "yellow",    "green",  "black",   "magic",
+                                   "nebula", "ghost",     "abandoned", "checkered", "zodiac", "painted",
+                                   "anaglyph", "plasma",  "erratic"};
+
+// Filled from JOKER_INFO, so they never go out of sync with the game
+static char joker_name_buffer[JOKER_ID_COUNT][MAX_JOKER_NAME_LENGTH];
+static const char *joker_names[JOKER_ID_COUNT];
+
+#define NAME_COUNT(names) (sizeof(names) / sizeof(*names))
+
+static FindingNames finding_names[FINDING_KIND_COUNT] = {
+    [FINDING_TAG] = {"tag", TAG_NAMES, NAME_COUNT(TAG_NAMES)},
+    [FINDING_BOSS] = {"boss", BOSS_NAMES, NAME_COUNT(BOSS_NAMES)},
+    [FINDING_VOUCHER] = {"voucher", VOUCHER_NAMES, NAME_COUNT(VOUCHER_NAMES)},
+    [FINDING_PACK] = {"pack", PACK_NAMES, NAME_COUNT(PACK_NAMES)},
+    [FINDING_JOKER] = {"joker", joker_names, JOKER_ID_COUNT},
+    [FINDING_EDITION] = {"edition", EDITION_NAMES, NAME_COUNT(EDITION_NAMES)},
+    [FINDING_TAROT] = {"tarot", TAROT_NAMES, NAME_COUNT(TAROT_NAMES)},
+    [FINDING_PLANET] = {"planet", PLANET_NAMES, NAME_COUNT(PLANET_NAMES)},
+    [FINDING_SPECTRAL] = {"spectral", SPECTRAL_NAMES, NAME_COUNT(SPECTRAL_NAMES)},
+};
+
+static Predicate predicates[MAX_PREDICATES];
+static uint8_t predicate_count = 0;
+static uint8_t max_ante = 0;
+static Deck deck = DECK_RED;
+static bool is_verbose = false;
+
+static void init_joker_names() {
+  for (JokerId id = JOKER_JOKER; id < JOKER_ID_COUNT; id++) {
+    char *name = joker_name_buffer[id];
+    snprintf(name, MAX_JOKER_NAME_LENGTH, "%s", JOKER_INFO[id].name);
+
+    for (char *c = name; *c != '\0'; c++) *c = *c == ' ' ? '_' : *c >= 'A' && *c <= 'Z' ? *c - 'A' + 'a' : *c;
+    joker_names[id] = name;
+  }
+}
+
+static int16_t find_name(const FindingNames *names, const char *name) {
+  for (uint8_t i = 0; i < names->count; i++)
+    if (names->names[i] != NULL && strcmp(names->names[i], name) == 0) return i;
+
+  return -1;
+}
+
+static const char *get_finding_name(const Finding *finding) {
+  const FindingNames *names = &finding_names[finding->kind];
+  return finding->value < names->count && names->names[finding->value] != NULL ? names->names[finding->value] : "?";
+}
+
+static bool parse_predicate(char *text, Predicate *predicate) {
+  char *name = strchr(text, ':');
+  if (name == NULL) return false;
+  *name++ = '\0';
+
+  char *ante = strchr(name, '@');
+  predicate->ante = 0;
+  if (ante != NULL) {
+    *ante++ = '\0';
+    predicate->ante = atoi(ante);
+    if (predicate->ante == 0) return false;
+  }
+
+  int16_t kind = -1;
+  for (uint8_t i = 0; i < FINDING_KIND_COUNT; i++)
+    if (strcmp(finding_names[i].kind, text) == 0) kind = i;
+  if (kind < 0) return false;
+  predicate->kind = kind;
+
+  int16_t value = find_name(&finding_names[kind], name);
+  predicate->first = predicate->last = value;
+
+  // Pack type without size matches all of its sizes
+  if (value < 0 && kind == FINDING_PACK) {
+    char pack_name[32];
+    snprintf(pack_name, sizeof(pack_name), "%s-normal", name);
+    value = find_name(&finding_names[kind], pack_name);
+    predicate->first = value;
+    predicate->last = value + BOOSTER_PACK_MEGA;
+  }
+
+  return value >= 0;
+}
+
+static void add_finding(Run *run, FindingKind kind, uint8_t value) {
+  uint8_t ante = run->context.ante;
+  if (ante > max_ante) return;
+
+  if (run->finding_count < MAX_FINDINGS)
+    run->findings[run->finding_count++] = (Finding){.kind = kind, .value = value, .ante = ante};
+
+  for (uint8_t i = 0; i < predicate_count; i++) {
+    Predicate *predicate = &predicates[i];
+    if (predicate->kind == kind && value >= predicate->first && value <= predicate->last &&
+        (predicate->ante == 0 || predicate->ante == ante))
+      run->matched |= 1u << i;
+  }
+}
+
+// Checks predicates which can't be matched anymore, so rest of the run doesn't have to be rolled.
+// Everything up to finished ante is known, from the given ante only its tags and boss blind are.
+static bool has_missed_predicates(Run *run, uint8_t ante) {
+  for (uint8_t i = 0; i < predicate_count; i++) {
+    Predicate *predicate = &predicates[i];
+    if (run->matched & 1u << i || predicate->ante == 0 || predicate->ante > ante) continue;
+    if (predicate->ante < ante || predicate->kind == FINDING_TAG || predicate->kind == FINDING_BOSS) return true;
+  }
+
+  return false;
+}
+
+static void add_item_finding(Run *run, ShopItem *item) {
+  switch (item->type) {
+    case SHOP_ITEM_JOKER:
+      add_finding(run, FINDING_JOKER, item->joker.id);
+      add_finding(run, FINDING_EDITION, item->joker.edition);
+      break;
+    case SHOP_ITEM_TAROT:
+      add_finding(run, FINDING_TAROT, item->tarot);
+      break;
+    case SHOP_ITEM_PLANET:
+      add_finding(run, FINDING_PLANET, item->planet);
+      break;
+    case SHOP_ITEM_SPECTRAL:
+      add_finding(run, FINDING_SPECTRAL, item->spectral);
+      break;
+    case SHOP_ITEM_CARD:
+      break;
+  }
+}
+
+static void simulate_ante_blinds(Run *run) {
+  set_random_subsystem(RANDOM_SUBSYSTEM_TAG);
+  for (uint8_t i = 0; i < 2; i++) add_finding(run, FINDING_TAG, pick_tag(&run->context));
+
+  set_random_subsystem(RANDOM_SUBSYSTEM_BOSS);
+  run->boss = pick_boss_blind(&run->context);
+  add_finding(run, FINDING_BOSS, run->boss);
+}
+
+// Mirrors open_booster_pack
+static void simulate_booster_pack(Run *run, BoosterPackItem *booster_pack) {
+  set_random_subsystem(RANDOM_SUBSYSTEM_BOOSTER_PACK);
+
+  OfferedItems offered = {0};
+  for (uint8_t i = 0; i < get_booster_pack_items_count(booster_pack); i++) {
+    ShopItem item = pick_booster_pack_item(&run->context, booster_pack->type, i, &offered);
+    offer_item(&offered, &item);
+    add_item_finding(run, &item);
+  }
+}
+
+// Mirrors restock_shop
+static void simulate_shop(Run *run, bool is_ante_first_shop) {
+  set_random_subsystem(RANDOM_SUBSYSTEM_SHOP);
+
+  OfferedItems offered = {0};
+  for (uint8_t i = 0; i < run->shop_size; i++) {
+    ShopItem item = pick_shop_item(&run->context, &offered);
+    offer_item(&offered, &item);
+    add_item_finding(run, &item);
+  }
+
+  BoosterPackItem booster_packs[2];
+  uint8_t booster_pack_count = 0;
+  if (run->round == 1)
+    booster_packs[booster_pack_count++] = (BoosterPackItem){.type = BOOSTER_PACK_BUFFOON, .size = BOOSTER_PACK_NORMAL};
+  while (booster_pack_count < 2) booster_packs[booster_pack_count++] = pick_booster_pack();
+
+  for (uint8_t i = 0; i < booster_pack_count; i++)
+    add_finding(run, FINDING_PACK, booster_packs[i].type * 3 + booster_packs[i].size);
+
+  // Voucher which wasn't bought stays in the Shop until it is replaced
+  if (is_ante_first_shop || run->round == 1) {
+    run->shop_voucher = pick_voucher(&run->context, run->shop_voucher);
+    add_finding(run, FINDING_VOUCHER, __builtin_ctz(run->shop_voucher));
+  }
+
+  for (uint8_t i = 0; i < booster_pack_count; i++) simulate_booster_pack(run, &booster_packs[i]);
+}
+
+// Mirrors game_init
+static void start_run(Run *run, uint32_t seed) {
+  set_random_seed(seed);
+
+  memset(run->owned_jokers, 0, sizeof(run->owned_jokers));
+  run->context = (RollContext){.ante = 1,
+                               .deck_type = deck,
+                               .defeated_boss_blinds = 0b11,
+                               .owned_jokers = run->owned_jokers,
+                               .unlocked_planets = ((1u << (PLANET_PLUTO + 1)) - 1) & ~((1u << (PLANET_X + 1)) - 1),
+                               .most_played_planet = PLANET_PLUTO};
+  run->round = 0;
+  run->shop_size = 2;
+  run->shop_voucher = 0;
+  run->finding_count = 0;
+  run->matched = 0;
+
+  simulate_ante_blinds(run);
+
+  switch (deck) {
+    case DECK_MAGIC:
+      run->context.vouchers |= VOUCHER_CRYSTAL_BALL;
+      break;
+    case DECK_NEBULA:
+      run->context.vouchers |= VOUCHER_TELESCOPE;
+      break;
+    case DECK_ZODIAC: {
+      // Overstock fills the extra Shop slot right away, those items are thrown away before the first Shop
+      run->context.vouchers |= VOUCHER_TAROT_MERCHANT | VOUCHER_PLANET_MERCHANT | VOUCHER_OVERSTOCK;
+      run->shop_size++;
+
+      set_random_subsystem(RANDOM_SUBSYSTEM_SHOP);
+      OfferedItems offered = {0};
+      for (uint8_t i = 0; i < run->shop_size; i++) {
+        ShopItem item = pick_shop_item(&run->context, &offered);
+        offer_item(&offered, &item);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Returns true when all predicates match
+static bool simulate_run(Run *run, uint32_t seed) {
+  start_run(run, seed);
+  if (has_missed_predicates(run, 1)) return false;
+
+  // Shop after the Boss Blind is the first one of next ante
+  for (uint8_t ante = 1; ante <= max_ante; ante++) {
+    for (uint8_t blind = 0; blind < 3; blind++) {
+      run->round++;
+
+      if (blind == 2) {
+        run->context.defeated_boss_blinds |= 1 << run->boss;
+        run->context.ante++;
+        advance_random_streams(run->context.ante);
+        simulate_ante_blinds(run);
+        if (has_missed_predicates(run, ante + 1)) return false;
+      }
+
+      simulate_shop(run, blind == 2);
+    }
+  }
+
+  return run->matched == (1ull << predicate_count) - 1;
+}
+
+static void scan_seeds(uint32_t first_seed, uint64_t seed_count) {
+  static Run run;
+
+  for (uint64_t i = 0; i < seed_count; i++) {
+    uint32_t seed = first_seed + i;
+    if (!simulate_run(&run, seed)) continue;
+
+    printf("%08X\n", seed);
+    for (uint16_t j = 0; is_verbose && j < run.finding_count; j++) {
+      Finding *finding = &run.findings[j];
+      printf("  ante %u %s %s\n", finding->ante, finding_names[finding->kind].kind, get_finding_name(finding));
+    }
+
+    // Whole seed is written at once, so output of parallel jobs doesn't interleave
+    fflush(stdout);
+  }
+}
+
+static void print_usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [-s first seed] [-n seed count] [-j jobs] [-a antes] [-d deck] [-v] predicate...\n"
+          "Seeds are hexadecimal, same as in game log. Predicates have form kind:name[@ante], e.g. tag:negative@1\n",
+          program);
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t first_seed = 0;
+  uint64_t seed_count = 1000000;
+  long job_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+  init_joker_names();
+
+  int option;
+  while ((option = getopt(argc, argv, "s:n:j:a:d:v")) != -1) {
+    switch (option) {
+      case 's':
+        first_seed = strtoul(optarg, NULL, 16);
+        break;
+      case 'n':
+        seed_count = strtoull(optarg, NULL, 0);
+        break;
+      case 'j':
+        job_count = atol(optarg);
+        break;
+      case 'a':
+        max_ante = atoi(optarg);
+        break;
+      case 'd': {
+        int16_t value = find_name(&(FindingNames){"deck", DECK_NAMES, NAME_COUNT(DECK_NAMES)}, optarg);
+        if (value < 0) {
+          fprintf(stderr, "Unknown deck %s\n", optarg);
+          return 1;
+        }
+        deck = value;
+        break;
+      }
+      case 'v':
+        is_verbose = true;
+        break;
+      default:
+        print_usage(argv[0]);
+        return 1;
+    }
+  }
+
+  for (int i = optind; i < argc; i++) {
+    if (predicate_count == MAX_PREDICATES) {
+      fprintf(stderr, "At most %d predicates are supported\n", MAX_PREDICATES);
+      return 1;
+    }
+
+    char text[64];
+    snprintf(text, sizeof(text), "%s", argv[i]);
+    if (!parse_predicate(text, &predicates[predicate_count])) {
+      fprintf(stderr, "Invalid predicate %s\n", argv[i]);
+      print_usage(argv[0]);
+      return 1;
+    }
+
+    if (predicates[predicate_count].ante > max_ante) max_ante = predicates[predicate_count].ante;
+    predicate_count++;
+  }
+
+  if (max_ante == 0) max_ante = 1;
+  if (seed_count > (1ull << 32)) seed_count = 1ull << 32;
+  if (job_count < 1) job_count = 1;
+  if ((uint64_t)job_count > seed_count) job_count = seed_count > 0 ? seed_count : 1;
+
+  // Jobs are separate processes, so generator and alias tables don't have to be shared between threads
+  setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+  for (long job = 0; job < job_count; job++) {
+    uint64_t start = seed_count * job / job_count;
+    uint64_t end = seed_count * (job + 1) / job_count;
+
+    pid_t pid = job_count == 1 ? 0 : fork();
+    if (pid < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (pid > 0) continue;
+
+    scan_seeds(first_seed + start, end - start);
+    if (job_count == 1) return 0;
+    exit(0);
+  }
+
+  int status;
+  while (wait(&status) > 0);
+  return 0;
+}
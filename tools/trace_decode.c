@@ -0,0 +1,205 @@
+// Host tool which turns binary trace recorded by the game into text log.
+// Build with: cc -o trace_decode tools/trace_decode.c
+// Usage: trace_decode joker_poker_trace.bin
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../trace.h"
+
+#define TRACE_LOG_MAX_WORDS (3 * TRACE_PAYLOAD_WORDS)
+
+typedef struct {
+  uint32_t address;
+  char *string;
+} TraceString;
+
+static const char *LOG_LEVEL_NAMES[] = {"INFO", "WARNING", "ERROR"};
+
+#define TRACE_EVENT_NAME(id, name, format) name,
+static const char *TRACE_EVENT_NAMES[] = {TRACE_EVENTS(TRACE_EVENT_NAME)};
+#undef TRACE_EVENT_NAME
+
+#define TRACE_EVENT_FORMAT(id, name, format) format,
+static const char *TRACE_EVENT_FORMATS[] = {TRACE_EVENTS(TRACE_EVENT_FORMAT)};
+#undef TRACE_EVENT_FORMAT
+
+static TraceString *strings = NULL;
+static size_t string_count = 0;
+
+static const char *find_string(uint32_t address) {
+  for (size_t i = 0; i < string_count; i++)
+    if (strings[i].address == address) return strings[i].string;
+
+  return "(unknown)";
+}
+
+static void add_string(uint32_t address, char *string) {
+  for (size_t i = 0; i < string_count; i++) {
+    if (strings[i].address != address) continue;
+
+    free(strings[i].string);
+    strings[i].string = string;
+    return;
+  }
+
+  strings = realloc(strings, (string_count + 1) * sizeof(TraceString));
+  strings[string_count++] = (TraceString){.address = address, .string = string};
+}
+
+// Formats words recorded on PSP, where every argument takes one 32-bit word apart from 64-bit integers and doubles
+static void print_message(const char *format, const uint32_t *words, uint8_t word_count) {
+  uint8_t word = 0;
+  char spec[32];
+
+  for (const char *c = format; *c != '\0'; c++) {
+    if (*c != '%') {
+      putchar(*c);
+      continue;
+    }
+
+    const char *start = c++;
+    while (*c != '\0' && strchr("-+ #0123456789.", *c) != NULL) c++;
+    size_t flags_length = c - start;
+
+    uint8_t is_long_long = 0;
+    if (*c == 'l' && c[1] == 'l') {
+      is_long_long = 1;
+      c += 2;
+    } else if (*c == 'j') {
+      is_long_long = 1;
+      c++;
+    } else {
+      while (*c != '\0' && strchr("hlzt", *c) != NULL) c++;
+    }
+
+    if (*c == '\0') break;
+    if (*c == '%') {
+      putchar('%');
+      continue;
+    }
+
+    uint8_t is_double = strchr("fFeEgGaA", *c) != NULL;
+    uint8_t size = is_double || is_long_long ? 2 : 1;
+    if (word + size > word_count || flags_length + 3 >= sizeof(spec)) {
+      printf("<missing>");
+      continue;
+    }
+
+    // Length modifiers are replaced with ones matching host types of recorded words
+    memcpy(spec, start, flags_length);
+    spec[flags_length] = '\0';
+    if (is_long_long) strcat(spec, "ll");
+    strncat(spec, c, 1);
+
+    uint64_t value = words[word];
+    if (size == 2) value |= (uint64_t)words[word + 1] << 32;
+    word += size;
+
+    if (is_double) {
+      double number;
+      memcpy(&number, &value, sizeof(number));
+      printf(spec, number);
+    } else if (is_long_long) {
+      printf(spec, (unsigned long long)value);
+    } else if (*c == 's') {
+      printf(spec, find_string(value));
+    } else if (*c == 'p') {
+      printf("0x%08x", (uint32_t)value);
+    } else {
+      printf(spec, (uint32_t)value);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+    return 1;
+  }
+
+  FILE *file = fopen(argv[1], "rb");
+  if (file == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  TraceFileHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TRACE_MAGIC ||
+      header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord)) {
+    fprintf(stderr, "%s is not a trace file of this version.\n", argv[1]);
+    fclose(file);
+    return 1;
+  }
+
+  TraceRecord record;
+  uint64_t time = 0;
+  uint32_t last_timestamp = 0;
+  uint8_t has_time = 0;
+
+  // Log message is printed once all of its argument records are read
+  uint32_t words[TRACE_LOG_MAX_WORDS];
+  uint8_t word_count = 0;
+  uint8_t level = 0;
+  uint64_t message_time = 0;
+
+  while (1) {
+    uint8_t has_record = fread(&record, sizeof(record), 1, file) == 1;
+
+    if (word_count > 0 && (!has_record || record.event != TRACE_EVENT_LOG_ARGUMENTS)) {
+      printf("[%12.6f] %-7s ", message_time / 1000000.0, level < 3 ? LOG_LEVEL_NAMES[level] : "?");
+      print_message(find_string(words[0]), words + 1, word_count - 1);
+      putchar('\n');
+      word_count = 0;
+    }
+
+    if (!has_record) break;
+    if (record.word_count > TRACE_PAYLOAD_WORDS) record.word_count = TRACE_PAYLOAD_WORDS;
+
+    if (record.event == TRACE_EVENT_STRING) {
+      uint32_t length = record.payload[1];
+      size_t padded_length = (length + sizeof(TraceRecord) - 1) / sizeof(TraceRecord) * sizeof(TraceRecord);
+      char *string = calloc(padded_length + 1, 1);
+      if (fread(string, 1, padded_length, file) != padded_length) {
+        free(string);
+        break;
+      }
+
+      string[length] = '\0';
+      add_string(record.payload[0], string);
+      continue;
+    }
+
+    // Timestamps wrap around every ~71 minutes
+    if (has_time) time += (uint32_t)(record.timestamp - last_timestamp);
+    last_timestamp = record.timestamp;
+    has_time = 1;
+
+    if (record.event == TRACE_EVENT_LOG || record.event == TRACE_EVENT_LOG_ARGUMENTS) {
+      if (record.event == TRACE_EVENT_LOG) {
+        level = record.level;
+        message_time = time;
+      }
+
+      for (uint8_t i = 0; i < record.word_count && word_count < TRACE_LOG_MAX_WORDS; i++)
+        words[word_count++] = record.payload[i];
+      continue;
+    }
+
+    if (record.event >= TRACE_EVENT_COUNT) {
+      printf("[%12.6f] unknown event %d\n", time / 1000000.0, record.event);
+      continue;
+    }
+
+    printf("[%12.6f] %-7s ", time / 1000000.0, TRACE_EVENT_NAMES[record.event]);
+    print_message(TRACE_EVENT_FORMATS[record.event], record.payload, record.word_count);
+    putchar('\n');
+  }
+
+  for (size_t i = 0; i < string_count; i++) free(strings[i].string);
+  free(strings);
+  fclose(file);
+  return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Binary trace file layout, shared with host decoder in tools/trace_decode.c,
+// so it must not depend on anything from PSPSDK
+
+#define TRACE_MAGIC (0x5254504Au)  // "JPTR"
+#define TRACE_VERSION (1)
+
+#define TRACE_PAYLOAD_WORDS (6)
+
+// Typed events, arguments are formatted by decoder as 32-bit words with given format
+#define TRACE_EVENTS(X)                                                 \
+  X(TRACE_EVENT_LOG, "log", NULL)                                       \
+  X(TRACE_EVENT_LOG_ARGUMENTS, "log arguments", NULL)                   \
+  X(TRACE_EVENT_STRING, "string", NULL)                                 \
+  X(TRACE_EVENT_DROPPED, "dropped", "%u records were dropped")          \
+  X(TRACE_EVENT_INPUT, "input", "buttons 0x%08x")                       \
+  X(TRACE_EVENT_LAYOUT, "layout", "%u render commands, %u byte arena")  \
+  X(TRACE_EVENT_FRAME, "frame", "cpu %u us, %u byte display list")      \
+  X(TRACE_EVENT_GPU, "gpu", "gpu %u us")
+
+#define TRACE_EVENT_ENUM(id, name, format) id,
+typedef enum { TRACE_EVENTS(TRACE_EVENT_ENUM) TRACE_EVENT_COUNT } TraceEventId;
+#undef TRACE_EVENT_ENUM
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+} TraceFileHeader;
+
+// Log message is stored as address of its format string followed by raw argument words, spread over
+// one TRACE_EVENT_LOG record and as many TRACE_EVENT_LOG_ARGUMENTS records as needed.
+// Each string address is preceded in file by TRACE_EVENT_STRING record with its length in the second
+// word, followed by string bytes padded to whole records.
+typedef struct {
+  // Low 32 bits of system time in microseconds
+  uint32_t timestamp;
+  uint8_t event;
+  uint8_t level;
+  // Bit per payload word which holds address of a string
+  uint8_t string_mask;
+  uint8_t word_count;
+  uint32_t payload[TRACE_PAYLOAD_WORDS];
+} TraceRecord;
+
+#endif
@@ -4,6 +4,7 @@
 #include "content/tarot.h"
 #include "game.h"
 #include "renderer.h"
+#include "roll.h"
 #include "state.h"
 #include "text.h"
 
@@ -66,31 +67,26 @@ void get_shop_item_tooltip_content(Clay_String *name, Clay_String *description,
       break;
 
     case SHOP_ITEM_JOKER:
-      *name = (Clay_String){.chars = item->joker.name, .length = strlen(item->joker.name)};
-      *description = (Clay_String){.chars = item->joker.description, .length = strlen(item->joker.description)};
+      *name = static_clay_string(JOKER_INFO[item->joker.id].name);
+      *description = static_clay_string(JOKERS[item->joker.id].description);
       break;
 
     case SHOP_ITEM_PLANET:
-      *name = (Clay_String){.chars = get_planet_card_name(item->planet),
-                            .length = strlen(get_planet_card_name(item->planet))};
+      *name = static_clay_string(get_planet_card_name(item->planet));
       uint16_t hand_union = 1 << item->planet;
       ScorePair upgrade = get_planet_card_base_score(hand_union);
-      append_clay_string(description, "%s (+%u chips, +%0.lf mult)", get_poker_hand_name(hand_union), upgrade.chips,
+      append_clay_string(description, "%s (+%.0lf chips, +%0.lf mult)", get_poker_hand_name(hand_union), upgrade.chips,
                          upgrade.mult);
       break;
 
     case SHOP_ITEM_TAROT:
-      *name =
-          (Clay_String){.chars = get_tarot_card_name(item->tarot), .length = strlen(get_tarot_card_name(item->tarot))};
-      *description = (Clay_String){.chars = get_tarot_card_description(item->tarot),
-                                   .length = strlen(get_tarot_card_description(item->tarot))};
+      *name = static_clay_string(get_tarot_card_name(item->tarot));
+      *description = static_clay_string(get_tarot_card_description(item->tarot));
       break;
 
     case SHOP_ITEM_SPECTRAL:
-      *name = (Clay_String){.chars = get_spectral_card_name(item->spectral),
-                            .length = strlen(get_spectral_card_name(item->spectral))};
-      *description = (Clay_String){.chars = get_spectral_card_description(item->spectral),
-                                   .length = strlen(get_spectral_card_description(item->spectral))};
+      *name = static_clay_string(get_spectral_card_name(item->spectral));
+      *description = static_clay_string(get_spectral_card_description(item->spectral));
       break;
   }
 }
@@ -144,9 +140,8 @@ void get_nav_item_tooltip_content(Clay_String *name, Clay_String *description, N
 
     case NAVIGATION_SHOP_VOUCHER: {
       Voucher voucher = state.game.shop.vouchers[state.navigation.hovered];
-      *name = (Clay_String){.chars = get_voucher_name(voucher), .length = strlen(get_voucher_name(voucher))};
-      *description =
-          (Clay_String){.chars = get_voucher_description(voucher), .length = strlen(get_voucher_description(voucher))};
+      *name = static_clay_string(get_voucher_name(voucher));
+      *description = static_clay_string(get_voucher_description(voucher));
       break;
     }
 
@@ -0,0 +1,17 @@
+#ifndef VECTOR_H
+#define VECTOR_H
+
+// cvector allocates through these hooks, so it has to be included only by this header
+#ifdef CVECTOR_H_
+#error "Include vector.h instead of cvector.h"
+#endif
+
+#include "arena.h"
+
+#define cvector_clib_malloc vector_allocate
+#define cvector_clib_realloc vector_reallocate
+#define cvector_clib_free vector_free
+
+#include <cvector.h>
+
+#endif